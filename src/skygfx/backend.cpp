@@ -2,3 +2,181 @@
 
 using namespace skygfx;
 
+const std::string skygfx::MipmapComputeShaderCode = R"(
+#version 450 core
+
+#ifdef FILTER_KAISER
+layout(local_size_x = 8, local_size_y = 8) in;
+#else
+layout(local_size_x = 16, local_size_y = 16) in;
+#endif
+
+layout(push_constant) uniform _settings
+{
+	ivec2 src_size;
+	int mip_count;
+} settings;
+
+layout(binding = 0, FORMAT) uniform readonly image2D src;
+layout(binding = 1, FORMAT) uniform writeonly image2D dst0;
+layout(binding = 2, FORMAT) uniform writeonly image2D dst1;
+layout(binding = 3, FORMAT) uniform writeonly image2D dst2;
+layout(binding = 4, FORMAT) uniform writeonly image2D dst3;
+layout(binding = 5, FORMAT) uniform writeonly image2D dst4;
+layout(binding = 6, FORMAT) uniform writeonly image2D dst5;
+
+vec4 load(ivec2 pos)
+{
+	return imageLoad(src, clamp(pos, ivec2(0), settings.src_size - 1));
+}
+
+void store(int level, ivec2 pos, vec4 value)
+{
+	ivec2 size = max(settings.src_size >> (level + 1), ivec2(1));
+
+	if (level >= settings.mip_count || any(greaterThanEqual(pos, size)))
+		return;
+
+	if (level == 0)
+		imageStore(dst0, pos, value);
+	else if (level == 1)
+		imageStore(dst1, pos, value);
+	else if (level == 2)
+		imageStore(dst2, pos, value);
+	else if (level == 3)
+		imageStore(dst3, pos, value);
+	else if (level == 4)
+		imageStore(dst4, pos, value);
+	else
+		imageStore(dst5, pos, value);
+}
+
+#ifdef FILTER_KAISER
+
+// separable kaiser-windowed sinc, beta = 4, 6 taps around the 2x2 footprint
+
+const float weights[6] = float[](-0.020992, 0.094502, 0.42649, 0.42649, 0.094502, -0.020992);
+
+void main()
+{
+	ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	vec4 result = vec4(0.0);
+
+	for (int y = 0; y < 6; y++)
+	{
+		for (int x = 0; x < 6; x++)
+		{
+			result += load(pos * 2 + ivec2(x - 2, y - 2)) * weights[x] * weights[y];
+		}
+	}
+
+	store(0, pos, result);
+}
+
+#else
+
+// every group reduces a 64x64 source tile down to a single texel of the last mip
+
+shared vec4 tile[32][32];
+
+void main()
+{
+	ivec2 group_pos = ivec2(gl_WorkGroupID.xy) * 32;
+
+	for (int y = 0; y < 2; y++)
+	{
+		for (int x = 0; x < 2; x++)
+		{
+			ivec2 local_pos = ivec2(gl_LocalInvocationID.xy) * 2 + ivec2(x, y);
+			ivec2 src_pos = (group_pos + local_pos) * 2;
+
+			vec4 value = (load(src_pos) + load(src_pos + ivec2(1, 0)) +
+				load(src_pos + ivec2(0, 1)) + load(src_pos + ivec2(1, 1))) * 0.25;
+
+			tile[local_pos.y][local_pos.x] = value;
+			store(0, group_pos + local_pos, value);
+		}
+	}
+
+	for (int level = 1; level < 6; level++)
+	{
+		barrier();
+
+		int stride = 1 << (level - 1);
+		int size = 32 >> level;
+		ivec2 local_pos = ivec2(gl_LocalInvocationID.xy);
+
+		vec4 value = vec4(0.0);
+
+		if (local_pos.x < size && local_pos.y < size)
+		{
+			ivec2 pos = local_pos * stride * 2;
+
+			value = (tile[pos.y][pos.x] + tile[pos.y][pos.x + stride] +
+				tile[pos.y + stride][pos.x] + tile[pos.y + stride][pos.x + stride]) * 0.25;
+		}
+
+		barrier();
+
+		if (local_pos.x < size && local_pos.y < size)
+		{
+			ivec2 pos = local_pos * stride * 2;
+			tile[pos.y][pos.x] = value;
+			store(level, (group_pos >> level) + local_pos, value);
+		}
+	}
+}
+
+#endif
+)";
+
+std::optional<std::vector<std::string>> skygfx::GetMipmapComputeShaderDefines(PixelFormat format, MipmapFilter filter)
+{
+	static const std::unordered_map<PixelFormat, std::string> FormatMap = {
+		{ PixelFormat::R32Float, "r32f" },
+		{ PixelFormat::RG32Float, "rg32f" },
+		{ PixelFormat::RGBA32Float, "rgba32f" },
+		{ PixelFormat::R8UNorm, "r8" },
+		{ PixelFormat::RG8UNorm, "rg8" },
+		{ PixelFormat::RGBA8UNorm, "rgba8" }
+	};
+
+	if (!FormatMap.contains(format))
+		return std::nullopt;
+
+	std::vector<std::string> result = { "FORMAT=" + FormatMap.at(format) };
+
+	if (filter == MipmapFilter::Kaiser)
+		result.push_back("FILTER_KAISER");
+
+	return result;
+}
+
+std::vector<MipmapComputePass> skygfx::MakeMipmapComputePasses(uint32_t width, uint32_t height, uint32_t mip_count,
+	MipmapFilter filter)
+{
+	// box filter reduces up to MipmapComputeMaxMipsPerPass mips per dispatch in groupshared memory,
+	// kaiser filter has a wider footprint than a single group tile and goes one mip at a time
+
+	auto mips_per_pass = filter == MipmapFilter::Box ? MipmapComputeMaxMipsPerPass : 1;
+	auto texels_per_group = filter == MipmapFilter::Box ? 32u : 8u;
+
+	std::vector<MipmapComputePass> result;
+
+	for (uint32_t src_mip_level = 0; src_mip_level + 1 < mip_count; src_mip_level += mips_per_pass)
+	{
+		auto dst_width = GetMipWidth(width, src_mip_level + 1);
+		auto dst_height = GetMipHeight(height, src_mip_level + 1);
+
+		auto pass = MipmapComputePass{
+			.src_mip_level = src_mip_level,
+			.mip_count = std::min(mips_per_pass, mip_count - src_mip_level - 1),
+			.group_count_x = (dst_width + texels_per_group - 1) / texels_per_group,
+			.group_count_y = (dst_height + texels_per_group - 1) / texels_per_group
+		};
+
+		result.push_back(pass);
+	}
+
+	return result;
+}
@@ -11,6 +11,7 @@ namespace skygfx
 
 		virtual void resize(uint32_t width, uint32_t height) = 0;
 		virtual void setVsync(bool value) = 0;
+		virtual void setFramesInFlight(uint32_t count) = 0;
 
 		virtual void setTopology(Topology topology) = 0;
 		virtual void setViewport(std::optional<Viewport> viewport) = 0;
@@ -22,6 +23,11 @@ namespace skygfx
 		virtual void setVertexBuffer(const VertexBuffer** vertex_buffer, size_t count) = 0;
 		virtual void setIndexBuffer(IndexBufferHandle* handle) = 0;
 		virtual void setUniformBuffer(uint32_t binding, UniformBufferHandle* handle) = 0;
+		virtual void setPushConstants(const void* memory, size_t size) = 0;
+		virtual void setAsyncPipelineCompilation(bool value) = 0;
+		virtual uint32_t getPendingPipelinesCount() = 0;
+		virtual MemoryStats getMemoryStats() = 0;
+		virtual void setShaderCacheDirectory(const std::string& path) = 0;
 		virtual void setBlendMode(const std::optional<BlendMode>& blend_mode) = 0;
 		virtual void setDepthMode(const std::optional<DepthMode>& depth_mode) = 0;
 		virtual void setStencilMode(const std::optional<StencilMode>& stencil_mode) = 0;
@@ -31,6 +37,7 @@ namespace skygfx
 		virtual void setTextureAddress(TextureAddress value) = 0;
 		virtual void setFrontFace(FrontFace value) = 0;
 		virtual void setDepthBias(const std::optional<DepthBias> depth_bias) = 0;
+		virtual void setStoreAction(StoreAction color, StoreAction depth_stencil) = 0;
 
 		virtual void clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 			const std::optional<uint8_t>& stencil) = 0;
@@ -41,12 +48,15 @@ namespace skygfx
 			TextureHandle* dst_texture_handle) = 0;
 		virtual void present() = 0;
 
+		// destroy functions of the vulkan backend may be called on any thread,
+		// other backends expect them on the rendering thread like everything else
+
 		virtual TextureHandle* createTexture(uint32_t width, uint32_t height, PixelFormat format,
 			uint32_t mip_count) = 0;
 		virtual void writeTexturePixels(TextureHandle* handle, uint32_t width, uint32_t height, const void* memory,
 			uint32_t mip_level, uint32_t offset_x, uint32_t offset_y) = 0;
 		virtual std::vector<uint8_t> readTexturePixels(TextureHandle* handle, uint32_t mip_level) = 0;
-		virtual void generateMips(TextureHandle* handle) = 0;
+		virtual void generateMips(TextureHandle* handle, MipmapFilter filter) = 0;
 		virtual void destroyTexture(TextureHandle* handle) = 0;
 
 		virtual RenderTargetHandle* createRenderTarget(uint32_t width, uint32_t height, TextureHandle* texture) = 0;
@@ -67,6 +77,15 @@ namespace skygfx
 		virtual UniformBufferHandle* createUniformBuffer(size_t size) = 0;
 		virtual void destroyUniformBuffer(UniformBufferHandle* handle) = 0;
 		virtual void writeUniformBufferMemory(UniformBufferHandle* handle, const void* memory, size_t size) = 0;
+
+		virtual UploadId writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+			const void* memory, uint32_t mip_level) = 0;
+		virtual UploadId writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) = 0;
+		virtual UploadId writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) = 0;
+		virtual bool isUploadCompleted(UploadId id) = 0;
+		virtual void waitUpload(UploadId id) = 0;
 	};
 
 	class RaytracingBackend
@@ -79,21 +98,56 @@ namespace skygfx
 		virtual void dispatchRays(uint32_t width, uint32_t height, uint32_t depth) = 0;
 
 		virtual RaytracingShaderHandle* createRaytracingShader(const std::string& raygen_code,
-			const std::vector<std::string>& miss_code, const std::string& closesthit_code,
+			const std::vector<std::string>& miss_code, const std::vector<std::string>& closesthit_code,
 			const std::vector<std::string>& defines) = 0;
 		virtual void destroyRaytracingShader(RaytracingShaderHandle* handle) = 0;
 
 		virtual BottomLevelAccelerationStructureHandle* createBottomLevelAccelerationStructure(const void* vertex_memory,
 			uint32_t vertex_count, uint32_t vertex_stride, const void* index_memory, uint32_t index_count,
-			uint32_t index_stride, const glm::mat4& transform) = 0;
+			uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options) = 0;
+		virtual BottomLevelAccelerationStructureHandle* createBottomLevelAccelerationStructure(VertexBufferHandle* vertex_buffer,
+			uint32_t vertex_count, uint32_t vertex_offset, uint32_t vertex_stride, VertexFormat vertex_format,
+			IndexBufferHandle* index_buffer, uint32_t index_count, uint32_t index_offset, uint32_t index_stride,
+			const glm::mat4& transform, const AccelerationStructureBuildOptions& options) = 0;
 		virtual void destroyBottomLevelAccelerationStructure(BottomLevelAccelerationStructureHandle* handle) = 0;
 
 		virtual TopLevelAccelerationStructureHandle* createTopLevelAccelerationStructure(
-			const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures) = 0;
+			const std::vector<AccelerationStructureInstance>& instances) = 0;
+		virtual void updateTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle,
+			const std::vector<AccelerationStructureInstance>& instances) = 0;
 		virtual void destroyTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle) = 0;
 
 		virtual StorageBufferHandle* createStorageBuffer(size_t size) = 0;
 		virtual void destroyStorageBuffer(StorageBufferHandle* handle) = 0;
 		virtual void writeStorageBufferMemory(StorageBufferHandle* handle, const void* memory, size_t size) = 0;
 	};
+
+	class BindlessBackend
+	{
+	public:
+		virtual uint32_t getBindlessTextureIndex(TextureHandle* handle) = 0;
+	};
+
+	struct MipmapComputeSettings
+	{
+		glm::i32vec2 src_size;
+		int32_t mip_count;
+	};
+
+	struct MipmapComputePass
+	{
+		uint32_t src_mip_level;
+		uint32_t mip_count;
+		uint32_t group_count_x;
+		uint32_t group_count_y;
+	};
+
+	// binding 0 is the source mip, bindings 1..MipmapComputeMaxMipsPerPass are the written mips
+	constexpr uint32_t MipmapComputeMaxMipsPerPass = 6;
+
+	extern const std::string MipmapComputeShaderCode;
+
+	std::optional<std::vector<std::string>> GetMipmapComputeShaderDefines(PixelFormat format, MipmapFilter filter);
+	std::vector<MipmapComputePass> MakeMipmapComputePasses(uint32_t width, uint32_t height, uint32_t mip_count,
+		MipmapFilter filter);
 }
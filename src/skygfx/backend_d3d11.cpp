@@ -82,6 +82,7 @@ struct ContextD3D11
 	std::vector<RenderTargetD3D11*> render_targets;
 	ShaderD3D11* shader = nullptr;
 	std::vector<InputLayout> input_layouts;
+	UniformBufferD3D11* push_constants_buffer = nullptr;
 	
 	std::unordered_map<DepthStencilStateD3D11, ComPtr<ID3D11DepthStencilState>> depth_stencil_states;
 	DepthStencilStateD3D11 depth_stencil_state;
@@ -384,6 +385,8 @@ public:
 	}
 };
 
+static const size_t PushConstantsBufferSize = 256;
+
 class UniformBufferD3D11 : public BufferD3D11
 {
 public:
@@ -789,10 +792,13 @@ BackendD3D11::BackendD3D11(void* window, uint32_t width, uint32_t height, Adapte
 
 	CreateMainRenderTarget(width, height);
 	setRenderTarget(nullptr, 0);
+
+	gContext->push_constants_buffer = new UniformBufferD3D11(PushConstantsBufferSize);
 }
 
 BackendD3D11::~BackendD3D11()
 {
+	delete gContext->push_constants_buffer;
 	DestroyMainRenderTarget();
 	delete gContext;
 }
@@ -813,6 +819,10 @@ void BackendD3D11::setVsync(bool value)
 	gContext->vsync = value;
 }
 
+void BackendD3D11::setFramesInFlight(uint32_t count)
+{
+}
+
 void BackendD3D11::setTopology(Topology topology)
 {
 	const static std::unordered_map<Topology, D3D11_PRIMITIVE_TOPOLOGY> TopologyMap = {
@@ -951,6 +961,34 @@ void BackendD3D11::setUniformBuffer(uint32_t binding, UniformBufferHandle* handl
 	gContext->context->PSSetConstantBuffers(binding, 1, buffer->getD3D11Buffer().GetAddressOf());
 }
 
+void BackendD3D11::setPushConstants(const void* memory, size_t size)
+{
+	assert(size <= PushConstantsBufferSize);
+
+	auto buffer = gContext->push_constants_buffer;
+	buffer->write(memory, size);
+	gContext->context->VSSetConstantBuffers(PushConstantsBinding, 1, buffer->getD3D11Buffer().GetAddressOf());
+	gContext->context->PSSetConstantBuffers(PushConstantsBinding, 1, buffer->getD3D11Buffer().GetAddressOf());
+}
+
+void BackendD3D11::setAsyncPipelineCompilation(bool value)
+{
+}
+
+uint32_t BackendD3D11::getPendingPipelinesCount()
+{
+	return 0;
+}
+
+MemoryStats BackendD3D11::getMemoryStats()
+{
+	return {};
+}
+
+void BackendD3D11::setShaderCacheDirectory(const std::string& path)
+{
+}
+
 void BackendD3D11::setBlendMode(const std::optional<BlendMode>& blend_mode)
 {
 	gContext->blend_mode = blend_mode;
@@ -1005,6 +1043,10 @@ void BackendD3D11::setDepthBias(const std::optional<DepthBias> depth_bias)
 	gContext->rasterizer_state_dirty = true;
 }
 
+void BackendD3D11::setStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+}
+
 void BackendD3D11::clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
@@ -1122,7 +1164,7 @@ std::vector<uint8_t> BackendD3D11::readTexturePixels(TextureHandle* handle, uint
 	return texture->read(mip_level);
 }
 
-void BackendD3D11::generateMips(TextureHandle* handle)
+void BackendD3D11::generateMips(TextureHandle* handle, MipmapFilter filter)
 {
 	auto texture = (TextureD3D11*)handle;
 	texture->generateMips();
@@ -1216,4 +1258,34 @@ void BackendD3D11::writeUniformBufferMemory(UniformBufferHandle* handle, const v
 	buffer->write(memory, size);
 }
 
+UploadId BackendD3D11::writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+	const void* memory, uint32_t mip_level)
+{
+	writeTexturePixels(handle, width, height, memory, mip_level, 0, 0);
+	return 0;
+}
+
+UploadId BackendD3D11::writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeVertexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+UploadId BackendD3D11::writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeIndexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+bool BackendD3D11::isUploadCompleted(UploadId id)
+{
+	return true;
+}
+
+void BackendD3D11::waitUpload(UploadId id)
+{
+}
+
 #endif
@@ -111,6 +111,7 @@ struct ContextD3D12
 	std::unordered_map<uint32_t, TextureD3D12*> textures;
 	std::unordered_map<uint32_t, UniformBufferD3D12*> uniform_buffers;
 	std::vector<RenderTargetD3D12*> render_targets;
+	std::vector<uint8_t> push_constants;
 
 	PipelineStateD3D12 pipeline_state;
 	std::unordered_map<PipelineStateD3D12, ComPtr<ID3D12PipelineState>> pipeline_states;
@@ -237,6 +238,8 @@ public:
 	const auto& getRootSignature() const { return mRootSignature; }
 	const auto& getRequiredTypedDescriptorBindings() const { return mRequiredTypedDescriptorBindings; }
 	const auto& getBindingToRootIndexMap() const { return mBindingToRootIndexMap; }
+	auto getPushConstantsRootIndex() const { return mPushConstantsRootIndex; }
+	auto getPushConstantsSize() const { return mPushConstantsSize; }
 	const auto& getVertexShaderBlob() const { return mVertexShaderBlob; }
 	const auto& getPixelShaderBlob() const { return mPixelShaderBlob; }
 
@@ -245,6 +248,8 @@ private:
 	std::unordered_map< ShaderReflection::DescriptorType, std::unordered_map<uint32_t, ShaderReflection::Descriptor>> mRequiredTypedDescriptorBindings;
 	std::unordered_map<ShaderStage, std::unordered_map<uint32_t/*set*/, std::unordered_set<uint32_t>/*bindings*/>> mRequiredDescriptorSets;
 	std::unordered_map<uint32_t, uint32_t> mBindingToRootIndexMap;
+	std::optional<uint32_t> mPushConstantsRootIndex;
+	uint32_t mPushConstantsSize = 0;
 	ComPtr<ID3DBlob> mVertexShaderBlob;
 	ComPtr<ID3DBlob> mPixelShaderBlob;
 
@@ -307,6 +312,9 @@ public:
 			{
 				mRequiredDescriptorSets[reflection.stage][set] = bindings;
 			}
+
+			if (reflection.push_constants.has_value())
+				mPushConstantsSize = std::max(mPushConstantsSize, reflection.push_constants->size);
 		}
 
 		{
@@ -343,6 +351,16 @@ public:
 				}
 			}
 
+			// the push constant block is a cbuffer at PushConstantsBinding, fed from root constants
+			if (mPushConstantsSize > 0)
+			{
+				CD3DX12_ROOT_PARAMETER param;
+				param.InitAsConstants(mPushConstantsSize / 4, PushConstantsBinding);
+
+				mPushConstantsRootIndex = (uint32_t)params.size();
+				params.push_back(param);
+			}
+
 			auto desc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC((UINT)params.size(), params.data(), (UINT)static_samplers.size(),
 				static_samplers.data(), D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -1054,6 +1072,18 @@ static void EnsureGraphicsState(bool draw_indexed)
 		}
 	}
 
+	if (auto root_index = shader->getPushConstantsRootIndex(); root_index.has_value())
+	{
+		auto size = shader->getPushConstantsSize();
+
+		// bytes the shader declares but were not set are pushed as zeros
+		if (gContext->push_constants.size() < size)
+			gContext->push_constants.resize(size, 0);
+
+		gContext->cmdlist->SetGraphicsRoot32BitConstants(root_index.value(), size / 4,
+			gContext->push_constants.data(), 0);
+	}
+
 	EnsureViewport();
 	EnsureScissor();
 	EnsureTopology();
@@ -1215,6 +1245,10 @@ void BackendD3D12::setVsync(bool value)
 	// TODO: implement
 }
 
+void BackendD3D12::setFramesInFlight(uint32_t count)
+{
+}
+
 void BackendD3D12::setTopology(Topology topology)
 {
 	gContext->topology = topology;
@@ -1307,6 +1341,29 @@ void BackendD3D12::setUniformBuffer(uint32_t binding, UniformBufferHandle* handl
 	gContext->uniform_buffers[binding] = (UniformBufferD3D12*)handle;
 }
 
+void BackendD3D12::setPushConstants(const void* memory, size_t size)
+{
+	gContext->push_constants.assign((const uint8_t*)memory, (const uint8_t*)memory + size);
+}
+
+void BackendD3D12::setAsyncPipelineCompilation(bool value)
+{
+}
+
+uint32_t BackendD3D12::getPendingPipelinesCount()
+{
+	return 0;
+}
+
+MemoryStats BackendD3D12::getMemoryStats()
+{
+	return {};
+}
+
+void BackendD3D12::setShaderCacheDirectory(const std::string& path)
+{
+}
+
 void BackendD3D12::setBlendMode(const std::optional<BlendMode>& blend_mode)
 {
 	gContext->pipeline_state.blend_mode = blend_mode;
@@ -1346,6 +1403,10 @@ void BackendD3D12::setDepthBias(const std::optional<DepthBias> depth_bias)
 {
 }
 
+void BackendD3D12::setStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+}
+
 void BackendD3D12::clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
@@ -1494,7 +1555,7 @@ std::vector<uint8_t> BackendD3D12::readTexturePixels(TextureHandle* handle, uint
 	return texture->read(mip_level);
 }
 
-void BackendD3D12::generateMips(TextureHandle* handle)
+void BackendD3D12::generateMips(TextureHandle* handle, MipmapFilter filter)
 {
 	auto texture = (TextureD3D12*)handle;
 	texture->generateMips();
@@ -1600,4 +1661,34 @@ void BackendD3D12::writeUniformBufferMemory(UniformBufferHandle* handle, const v
 	buffer->write(memory, size);
 }
 
+UploadId BackendD3D12::writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+	const void* memory, uint32_t mip_level)
+{
+	writeTexturePixels(handle, width, height, memory, mip_level, 0, 0);
+	return 0;
+}
+
+UploadId BackendD3D12::writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeVertexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+UploadId BackendD3D12::writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeIndexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+bool BackendD3D12::isUploadCompleted(UploadId id)
+{
+	return true;
+}
+
+void BackendD3D12::waitUpload(UploadId id)
+{
+}
+
 #endif
@@ -4,10 +4,15 @@
 
 //#define SKYGFX_OPENGL_VALIDATION_ENABLED
 
+#include <array>
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <stdexcept>
 #include <iostream>
+#include <filesystem>
+#include <fstream>
+#include <random>
 #include "shader_compiler.h"
 
 #if defined(SKYGFX_PLATFORM_WINDOWS)
@@ -44,6 +49,15 @@ extern "C" {
 #define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
 #endif
 
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
 using namespace skygfx;
 
 #ifdef SKYGFX_OPENGL_VALIDATION_ENABLED
@@ -217,12 +231,114 @@ static const std::unordered_map<PixelFormat, GLenum> TextureFormatMap = {
 	{ PixelFormat::RGBA8UNorm, GL_RGBA },
 };
 
+// set up before the context is created, so objects made by the context itself see them too
+static bool gBufferStorageEnabled = false;
+static bool gDirectStateAccessEnabled = false;
+static GLint gUniformBufferOffsetAlignment = 256;
+
+// shadow copy of the bindings that editing objects disturbs, they are restored without glGet round-trips,
+// it stays outside of ContextGL like the flags above: the object classes that edit through it are defined
+// before ContextGL, and it is reset and synced with the drawable before the context is created
+struct BindingsGL
+{
+	GLuint program = 0;
+	GLuint framebuffer = 0;
+	uint32_t active_texture = 0;
+	std::unordered_map<uint32_t, GLuint> textures;
+};
+
+static BindingsGL gBindings;
+
+static void UseProgram(GLuint program)
+{
+	glUseProgram(program);
+	gBindings.program = program;
+}
+
+static void BindFramebuffer(GLuint framebuffer)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	gBindings.framebuffer = framebuffer;
+}
+
+static void BindTexture(uint32_t unit, GLuint texture)
+{
+	if (gBindings.active_texture != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		gBindings.active_texture = unit;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	gBindings.textures[unit] = texture;
+}
+
+// cached program binaries start with a header, files of other formats, codegen or keys are recompiled
+
+static const uint32_t ProgramBinaryMagic = 0x42505853; // "SXPB"
+static const uint32_t ProgramBinaryFormatVersion = 1;
+static const uint32_t ShaderCodegenVersion = 1; // bump when the glsl generated for the same source changes
+
+struct ProgramBinaryCacheEntryGL
+{
+	std::filesystem::path path;
+	std::string key;
+};
+
+template <typename T>
+static void WriteBinaryValue(std::ofstream& file, const T& value)
+{
+	file.write((const char*)&value, sizeof(value));
+}
+
+template <typename T>
+static bool ReadBinaryValue(std::ifstream& file, T& value)
+{
+	return (bool)file.read((char*)&value, sizeof(value));
+}
+
+static void WriteBinaryString(std::ofstream& file, const std::string& str)
+{
+	WriteBinaryValue(file, (uint32_t)str.size());
+	file.write(str.data(), str.size());
+}
+
+// sizes read from a cache file are checked against what is left in it, so a damaged file
+// is rejected instead of allocating whatever it claims
+static uint64_t GetRemainingSize(std::ifstream& file)
+{
+	auto position = file.tellg();
+	file.seekg(0, std::ios::end);
+	auto end = file.tellg();
+	file.seekg(position);
+
+	if (!file || end < position)
+		return 0;
+
+	return (uint64_t)(end - position);
+}
+
+static bool ReadBinaryString(std::ifstream& file, std::string& str)
+{
+	uint32_t size = 0;
+
+	if (!ReadBinaryValue(file, size) || size > GetRemainingSize(file))
+		return false;
+
+	str.resize(size);
+	return (bool)file.read(str.data(), size);
+}
+
 class ShaderGL
 {
+private:
+	// names of the blocks and samplers with the bindings they get assigned after linking, stored with cached binaries
+	using NamedBindings = std::vector<std::tuple<std::string, uint32_t>>;
+
 private:
 	GLuint mProgram;
-	ShaderReflection mVertRefl;
-	ShaderReflection mFragRefl;
+	NamedBindings mUniformBlockBindings;
+	NamedBindings mSamplerBindings;
 
 	struct {
 		bool es;
@@ -236,13 +352,8 @@ public:
 
 public:
 	ShaderGL(const std::string& vertex_code, const std::string& fragment_code,
-		std::vector<std::string> defines)
+		std::vector<std::string> defines, const std::optional<ProgramBinaryCacheEntryGL>& binary_cache_entry)
 	{
-		defines.push_back("FLIP_TEXCOORD_Y");
-
-		auto vertex_shader_spirv = CompileGlslToSpirv(ShaderStage::Vertex, vertex_code, defines);
-		auto fragment_shader_spirv = CompileGlslToSpirv(ShaderStage::Fragment, fragment_code, defines);
-
 #if defined(SKYGFX_PLATFORM_IOS)
 		options.es = true;
 		options.version = 300;
@@ -267,6 +378,24 @@ public:
 		options.force_flattened_io_blocks = false;
 #endif
 
+		bool need_fix_bindings =
+			(options.es && options.version <= 300) ||
+			(!options.es && options.version < 420 && !options.enable_420pack_extension);
+
+		if (binary_cache_entry.has_value() && loadProgramBinary(binary_cache_entry.value()))
+		{
+			// bindings set after linking are not part of the binary
+			if (need_fix_bindings)
+				fixBindings();
+
+			return;
+		}
+
+		defines.push_back("FLIP_TEXCOORD_Y");
+
+		auto vertex_shader_spirv = CompileGlslToSpirv(ShaderStage::Vertex, vertex_code, defines);
+		auto fragment_shader_spirv = CompileGlslToSpirv(ShaderStage::Fragment, fragment_code, defines);
+
 		auto glsl_vert = skygfx::CompileSpirvToGlsl(vertex_shader_spirv, options.es, options.version,
 			options.enable_420pack_extension, options.force_flattened_io_blocks);
 
@@ -303,6 +432,10 @@ public:
 		mProgram = glCreateProgram();
 		glAttachShader(mProgram, vertexShader);
 		glAttachShader(mProgram, fragmentShader);
+#if !defined(SKYGFX_PLATFORM_EMSCRIPTEN)
+		if (binary_cache_entry.has_value())
+			glProgramParameteri(mProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
 		glLinkProgram(mProgram);
 
 		GLint link_status = 0;
@@ -314,61 +447,204 @@ public:
 		glDeleteShader(vertexShader);
 		glDeleteShader(fragmentShader);
 
-		mVertRefl = MakeSpirvReflection(vertex_shader_spirv);
-		mFragRefl = MakeSpirvReflection(fragment_shader_spirv);
-
-		bool need_fix_bindings =
-			(options.es && options.version <= 300) ||
-			(!options.es && options.version < 420 && !options.enable_420pack_extension);
-
-		if (need_fix_bindings)
+		for (const auto& spirv : { vertex_shader_spirv, fragment_shader_spirv })
 		{
-			auto for_each_descriptor_binding = [&](auto type, std::function<void(uint32_t binding, const ShaderReflection::Descriptor& descriptor)> callback){
-				for (const auto& reflection : { mVertRefl, mFragRefl })
+			auto reflection = MakeSpirvReflection(spirv);
+
+			for (const auto& [type, descriptor_bindings] : reflection.typed_descriptor_bindings)
+			{
+				for (const auto& [binding, descriptor] : descriptor_bindings)
 				{
-					if (!reflection.typed_descriptor_bindings.contains(type))
-						continue;
+					if (type == ShaderReflection::DescriptorType::UniformBuffer)
+						mUniformBlockBindings.push_back({ descriptor.type_name, binding });
+					else if (type == ShaderReflection::DescriptorType::CombinedImageSampler)
+						mSamplerBindings.push_back({ descriptor.name, binding });
+				}
+			}
 
-					for (const auto& [binding, descriptor] : reflection.typed_descriptor_bindings.at(type))
-					{
-						callback(binding, descriptor);
-					}
-				};
-			};
-			for_each_descriptor_binding(ShaderReflection::DescriptorType::UniformBuffer, [&](auto binding, const auto& descriptor){
-				auto block_index = glGetUniformBlockIndex(mProgram, descriptor.type_name.c_str());
-				glUniformBlockBinding(mProgram, block_index, binding);
-			});
-			GLint prevProgram = 0;
-			glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
-			glUseProgram(mProgram);
-			for_each_descriptor_binding(ShaderReflection::DescriptorType::CombinedImageSampler, [&](auto binding, const auto& descriptor){
-				auto location = glGetUniformLocation(mProgram, descriptor.name.c_str());
-				glUniform1i(location, binding);
-			});
-			glUseProgram(prevProgram);
+			if (reflection.push_constants.has_value())
+				mUniformBlockBindings.push_back({ reflection.push_constants->type_name, PushConstantsBinding });
 		}
+
+		if (need_fix_bindings)
+			fixBindings();
+
+		if (binary_cache_entry.has_value())
+			saveProgramBinary(binary_cache_entry.value());
 	}
 
 	~ShaderGL()
 	{
 		glDeleteProgram(mProgram);
 	}
+
+private:
+	void fixBindings() const
+	{
+		for (const auto& [name, binding] : mUniformBlockBindings)
+		{
+			auto block_index = glGetUniformBlockIndex(mProgram, name.c_str());
+			glUniformBlockBinding(mProgram, block_index, binding);
+		}
+
+		auto prev_program = gBindings.program;
+		UseProgram(mProgram);
+
+		for (const auto& [name, binding] : mSamplerBindings)
+		{
+			auto location = glGetUniformLocation(mProgram, name.c_str());
+			glUniform1i(location, binding);
+		}
+
+		UseProgram(prev_program);
+	}
+
+	static bool ReadNamedBindings(std::ifstream& file, NamedBindings& named_bindings)
+	{
+		uint32_t count = 0;
+
+		if (!ReadBinaryValue(file, count))
+			return false;
+
+		// every entry takes at least its name size and binding
+		if (count > GetRemainingSize(file) / (sizeof(uint32_t) * 2))
+			return false;
+
+		named_bindings.resize(count);
+
+		for (auto& [name, binding] : named_bindings)
+		{
+			if (!ReadBinaryString(file, name) || !ReadBinaryValue(file, binding))
+				return false;
+		}
+
+		return true;
+	}
+
+	static void WriteNamedBindings(std::ofstream& file, const NamedBindings& named_bindings)
+	{
+		WriteBinaryValue(file, (uint32_t)named_bindings.size());
+
+		for (const auto& [name, binding] : named_bindings)
+		{
+			WriteBinaryString(file, name);
+			WriteBinaryValue(file, binding);
+		}
+	}
+
+	bool loadProgramBinary(const ProgramBinaryCacheEntryGL& entry)
+	{
+#if defined(SKYGFX_PLATFORM_EMSCRIPTEN)
+		return false;
+#else
+		std::ifstream file(entry.path, std::ios::binary);
+
+		if (!file)
+			return false;
+
+		uint32_t magic = 0;
+		uint32_t format_version = 0;
+		uint32_t codegen_version = 0;
+		std::string key;
+
+		if (!ReadBinaryValue(file, magic) || magic != ProgramBinaryMagic)
+			return false;
+
+		if (!ReadBinaryValue(file, format_version) || format_version != ProgramBinaryFormatVersion)
+			return false;
+
+		if (!ReadBinaryValue(file, codegen_version) || codegen_version != ShaderCodegenVersion)
+			return false;
+
+		// the file name is only a hash of the key, a collision must not load another program
+		if (!ReadBinaryString(file, key) || key != entry.key)
+			return false;
+
+		NamedBindings uniform_block_bindings;
+		NamedBindings sampler_bindings;
+
+		if (!ReadNamedBindings(file, uniform_block_bindings) || !ReadNamedBindings(file, sampler_bindings))
+			return false;
+
+		GLenum format = 0;
+
+		if (!ReadBinaryValue(file, format))
+			return false;
+
+		auto binary = std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		if (binary.empty())
+			return false;
+
+		mProgram = glCreateProgram();
+		glProgramBinary(mProgram, format, binary.data(), (GLsizei)binary.size());
+
+		GLint link_status = 0;
+		glGetProgramiv(mProgram, GL_LINK_STATUS, &link_status);
+
+		if (link_status == GL_FALSE)
+		{
+			// binaries are rejected after driver updates, the program is compiled from source then
+			glDeleteProgram(mProgram);
+			mProgram = 0;
+			return false;
+		}
+
+		mUniformBlockBindings = std::move(uniform_block_bindings);
+		mSamplerBindings = std::move(sampler_bindings);
+		return true;
+#endif
+	}
+
+	void saveProgramBinary(const ProgramBinaryCacheEntryGL& entry) const
+	{
+#if !defined(SKYGFX_PLATFORM_EMSCRIPTEN)
+		GLint length = 0;
+		glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length == 0)
+			return;
+
+		GLenum format = 0;
+		std::vector<char> binary(length);
+		glGetProgramBinary(mProgram, length, &length, &format, binary.data());
+
+		// written next to the entry and renamed over it, so a crash or another process
+		// never leaves a partially written file under the entry path
+		auto temp_path = entry.path;
+		temp_path += ".tmp" + std::to_string(std::random_device()());
+
+		std::ofstream file(temp_path, std::ios::binary);
+		WriteBinaryValue(file, ProgramBinaryMagic);
+		WriteBinaryValue(file, ProgramBinaryFormatVersion);
+		WriteBinaryValue(file, ShaderCodegenVersion);
+		WriteBinaryString(file, entry.key);
+		WriteNamedBindings(file, mUniformBlockBindings);
+		WriteNamedBindings(file, mSamplerBindings);
+		WriteBinaryValue(file, format);
+		file.write(binary.data(), length);
+		file.close();
+
+		std::error_code error;
+
+		if (file)
+			std::filesystem::rename(temp_path, entry.path, error);
+
+		if (!file || error)
+			std::filesystem::remove(temp_path, error);
+#endif
+	}
 };
 
-static std::vector<uint8_t> FlipPixels(const void* memory, uint32_t width, uint32_t height, uint32_t channels_count,
-	uint32_t channel_size)
+static void FlipPixels(void* memory, size_t row_size, uint32_t height)
 {
-	auto row_size = width * channels_count * channel_size;
-	auto image_size = height * row_size;
-	auto result = std::vector<uint8_t>(image_size);
-	for (uint32_t i = 0; i < height; i++)
+	auto pixels = (uint8_t*)memory;
+	for (uint32_t i = 0; i < height / 2; i++)
 	{
-		auto src = (void*)(size_t(memory) + (size_t(i) * row_size));
-		auto dst = (void*)(size_t(result.data()) + (size_t(height - 1 - i) * row_size));
-		memcpy(dst, src, row_size);
+		auto top = pixels + (size_t(i) * row_size);
+		auto bottom = pixels + (size_t(height - 1 - i) * row_size);
+		std::swap_ranges(top, top + row_size, bottom);
 	}
-	return result;
 }
 
 class TextureGL
@@ -377,19 +653,21 @@ public:
 	class ScopedBind : public skygfx::noncopyable
 	{
 	public:
-		ScopedBind(GLuint texture)
+		ScopedBind(GLuint texture) :
+			mUnit(gBindings.active_texture),
+			mLastTexture(gBindings.textures[gBindings.active_texture])
 		{
-			glGetIntegerv(GL_TEXTURE_BINDING_2D, &mLastTexture);
-			glBindTexture(GL_TEXTURE_2D, texture);
+			BindTexture(mUnit, texture);
 		}
 
 		~ScopedBind()
 		{
-			glBindTexture(GL_TEXTURE_2D, mLastTexture);
+			BindTexture(mUnit, mLastTexture);
 		}
 
 	private:
-		GLint mLastTexture = 0;
+		uint32_t mUnit = 0;
+		GLuint mLastTexture = 0;
 	};
 
 public:
@@ -413,9 +691,20 @@ public:
 		mFormat(format),
 		mMipCount(mip_count)
 	{
+		auto internal_format = TextureInternalFormatMap.at(mFormat);
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gDirectStateAccessEnabled)
+		{
+			glCreateTextures(GL_TEXTURE_2D, 1, &mTexture);
+			glTextureStorage2D(mTexture, mip_count, internal_format, width, height);
+			glTextureParameteri(mTexture, GL_TEXTURE_MAX_LEVEL, mip_count - 1);
+			return;
+		}
+#endif
+
 		glGenTextures(1, &mTexture);
 
-		auto internal_format = TextureInternalFormatMap.at(mFormat);
 		auto texture_format = TextureFormatMap.at(mFormat);
 		auto format_type = PixelFormatTypeMap.at(mFormat);
 		auto binding = ScopedBind(mTexture);
@@ -434,40 +723,69 @@ public:
 	~TextureGL()
 	{
 		glDeleteTextures(1, &mTexture);
+
+		// deleted textures are unbound from every unit
+		for (auto& [unit, texture] : gBindings.textures)
+		{
+			if (texture == mTexture)
+				texture = 0;
+		}
 	}
 
 	void write(uint32_t width, uint32_t height, const void* memory,
-		uint32_t mip_level, uint32_t offset_x, uint32_t offset_y)
+		uint32_t mip_level, uint32_t offset_x, uint32_t offset_y, GLuint pixel_buffer)
 	{
 		auto channels_count = GetFormatChannelsCount(mFormat);
 		auto channel_size = GetFormatChannelSize(mFormat);
 		auto format_type = PixelFormatTypeMap.at(mFormat);
 		auto texture_format = TextureFormatMap.at(mFormat);
-		auto flipped_image = FlipPixels(memory, width, height, channels_count, channel_size);
 		auto mip_height = GetMipHeight(mHeight, mip_level);
-		auto binding = ScopedBind(mTexture);
+		auto row_size = size_t(width) * channels_count * channel_size;
+		auto image_size = row_size * height;
+		auto pixels = (const uint8_t*)memory;
 
-		glTexSubImage2D(GL_TEXTURE_2D, mip_level, offset_x, (mip_height - height) - offset_y, width, height,
-			texture_format, format_type, flipped_image.data());
-	}
+		// rows are flipped while streaming into the pixel buffer, the orphaned storage
+		// lets the driver keep transferring the previous upload
 
-	std::vector<uint8_t> read(uint32_t mip_level) const
-	{
-		GLuint fbo = 0;
-		glGenFramebuffers(1, &fbo);
-		
-		GLint old_fbo;
-		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &old_fbo);
-		
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 
-			GL_TEXTURE_2D, mTexture, mip_level);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, image_size, NULL, GL_STREAM_DRAW);
 
-#ifdef SKYGFX_OPENGL_VALIDATION_ENABLED
-		auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		assert(status == GL_FRAMEBUFFER_COMPLETE);
+#if defined(SKYGFX_PLATFORM_EMSCRIPTEN)
+		// webgl can not map buffers, every call is a copy through javascript, so the rows
+		// are flipped on our side and handed over at once
+		auto flipped_pixels = std::vector<uint8_t>(pixels, pixels + image_size);
+		FlipPixels(flipped_pixels.data(), row_size, height);
+		glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, image_size, flipped_pixels.data());
+#else
+		auto dst = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image_size, GL_MAP_WRITE_BIT |
+			GL_MAP_INVALIDATE_BUFFER_BIT);
+
+		for (uint32_t i = 0; i < height; i++)
+		{
+			memcpy(dst + (size_t(height - 1 - i) * row_size), pixels + (size_t(i) * row_size), row_size);
+		}
+
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
 #endif
 
+		auto y = (mip_height - height) - offset_y;
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gDirectStateAccessEnabled)
+		{
+			glTextureSubImage2D(mTexture, mip_level, offset_x, y, width, height, texture_format, format_type, NULL);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return;
+		}
+#endif
+
+		auto binding = ScopedBind(mTexture);
+		glTexSubImage2D(GL_TEXTURE_2D, mip_level, offset_x, y, width, height, texture_format, format_type, NULL);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	std::vector<uint8_t> read(uint32_t mip_level) const
+	{
 		auto mip_width = GetMipWidth(mWidth, mip_level);
 		auto mip_height = GetMipHeight(mHeight, mip_level);
 
@@ -479,22 +797,50 @@ public:
 		size_t row_size = mip_width * channels_count * channel_size;
 		size_t image_size = mip_height * row_size;
 
-		GLint pack_alignment;
-		glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
-		glPixelStorei(GL_PACK_ALIGNMENT, 1);
-
 		std::vector<uint8_t> buffer(image_size);
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gDirectStateAccessEnabled)
+		{
+			glGetTextureImage(mTexture, mip_level, texture_format, format_type, (GLsizei)image_size, buffer.data());
+			FlipPixels(buffer.data(), row_size, mip_height);
+			return buffer;
+		}
+#endif
+
+		GLuint fbo = 0;
+		glGenFramebuffers(1, &fbo);
+
+		auto last_fbo = gBindings.framebuffer;
+
+		BindFramebuffer(fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, mip_level);
+
+#ifdef SKYGFX_OPENGL_VALIDATION_ENABLED
+		auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		assert(status == GL_FRAMEBUFFER_COMPLETE);
+#endif
+
 		glReadPixels(0, 0, mip_width, mip_height, texture_format, format_type, buffer.data());
 
-		glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
-		glBindFramebuffer(GL_FRAMEBUFFER, old_fbo);
+		BindFramebuffer(last_fbo);
 		glDeleteFramebuffers(1, &fbo);
 
-		return FlipPixels(buffer.data(), mip_width, mip_height, channels_count, channel_size);
+		FlipPixels(buffer.data(), row_size, mip_height);
+
+		return buffer;
 	}
 
 	void generateMips()
 	{
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gDirectStateAccessEnabled)
+		{
+			glGenerateTextureMipmap(mTexture);
+			return;
+		}
+#endif
+
 		auto binding = ScopedBind(mTexture);
 		glGenerateMipmap(GL_TEXTURE_2D);
 	}
@@ -514,18 +860,31 @@ private:
 public:
 	RenderTargetGL(TextureGL* texture) : mTexture(texture)
 	{
-		GLint last_fbo;
-		GLint last_rbo;
+		auto width = mTexture->getWidth();
+		auto height = mTexture->getHeight();
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gDirectStateAccessEnabled)
+		{
+			glCreateRenderbuffers(1, &mDepthStencilRenderbuffer);
+			glNamedRenderbufferStorage(mDepthStencilRenderbuffer, GL_DEPTH24_STENCIL8, width, height);
 
-		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_fbo);
-		glGetIntegerv(GL_RENDERBUFFER_BINDING, &last_rbo);
+			glCreateFramebuffers(1, &mFramebuffer);
+			glNamedFramebufferRenderbuffer(mFramebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER,
+				mDepthStencilRenderbuffer);
+			return;
+		}
+#endif
 
+		// the renderbuffer binding is not used anywhere else, so it is not restored
 		glGenRenderbuffers(1, &mDepthStencilRenderbuffer);
 		glBindRenderbuffer(GL_RENDERBUFFER, mDepthStencilRenderbuffer);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mTexture->getWidth(), mTexture->getHeight());
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+		auto last_fbo = gBindings.framebuffer;
 
 		glGenFramebuffers(1, &mFramebuffer);
-		glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+		BindFramebuffer(mFramebuffer);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthStencilRenderbuffer);
 
 #ifdef SKYGFX_OPENGL_VALIDATION_ENABLED
@@ -533,31 +892,191 @@ public:
 		assert(status == GL_FRAMEBUFFER_COMPLETE);
 #endif
 
-		glBindFramebuffer(GL_FRAMEBUFFER, last_fbo);
-		glBindRenderbuffer(GL_RENDERBUFFER, last_rbo);
+		BindFramebuffer(last_fbo);
 	}
 
 	~RenderTargetGL()
 	{
 		glDeleteFramebuffers(1, &mFramebuffer);
 		glDeleteRenderbuffers(1, &mDepthStencilRenderbuffer);
+
+		// deleting the bound framebuffer reverts the binding to the default one
+		if (gBindings.framebuffer == mFramebuffer)
+			gBindings.framebuffer = 0;
 	}
 };
 
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+static const uint32_t FrameUploadsCount = 3;
+
+struct UploadPageGL
+{
+	GLuint buffer = 0;
+	uint8_t* memory_ptr = nullptr;
+	size_t size = 0;
+	size_t offset = 0;
+};
+
+struct FrameUploadsGL
+{
+	std::vector<UploadPageGL> pages;
+	GLsync fence = nullptr;
+};
+
+// writes of a frame share persistently mapped pages, one set per frame in flight, fenced once per frame
+static std::array<FrameUploadsGL, FrameUploadsCount> gFrameUploads;
+static uint32_t gFrameUploadsIndex = 0;
+
+static void WaitFence(GLsync& fence)
+{
+	if (fence == nullptr)
+		return;
+
+	while (true)
+	{
+		auto result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+		if (result != GL_TIMEOUT_EXPIRED)
+			break;
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+static std::tuple<GLuint, size_t, uint8_t*> AllocateFrameUploadMemory(size_t size)
+{
+	// linear allocator over the pages of the frame, rewound when the frame is reused
+
+	constexpr size_t PageSize = 4 * 1024 * 1024;
+
+	auto& pages = gFrameUploads.at(gFrameUploadsIndex).pages;
+	auto alignment = (size_t)gUniformBufferOffsetAlignment;
+
+	auto align_up = [alignment](size_t offset) {
+		return (offset + alignment - 1) / alignment * alignment;
+	};
+
+	auto page = std::find_if(pages.begin(), pages.end(), [&](const UploadPageGL& candidate) {
+		return align_up(candidate.offset) + size <= candidate.size;
+	});
+
+	if (page == pages.end())
+	{
+		auto new_page = UploadPageGL();
+		new_page.size = std::max(PageSize, size);
+
+		auto storage_size = (GLsizeiptr)new_page.size;
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		if (gDirectStateAccessEnabled)
+		{
+			glCreateBuffers(1, &new_page.buffer);
+			glNamedBufferStorage(new_page.buffer, storage_size, NULL, flags);
+			new_page.memory_ptr = (uint8_t*)glMapNamedBufferRange(new_page.buffer, 0, storage_size, flags);
+		}
+		else
+		{
+			glGenBuffers(1, &new_page.buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, new_page.buffer);
+			glBufferStorage(GL_COPY_WRITE_BUFFER, storage_size, NULL, flags);
+			new_page.memory_ptr = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, storage_size, flags);
+		}
+
+		pages.push_back(new_page);
+		page = std::prev(pages.end());
+	}
+
+	auto offset = align_up(page->offset);
+	page->offset = offset + size;
+
+	return { page->buffer, offset, page->memory_ptr + offset };
+}
+
+static void AdvanceFrameUploads()
+{
+	auto& frame_uploads = gFrameUploads.at(gFrameUploadsIndex);
+
+	if (!frame_uploads.pages.empty())
+		frame_uploads.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	gFrameUploadsIndex = (gFrameUploadsIndex + 1) % FrameUploadsCount;
+
+	auto& next_frame_uploads = gFrameUploads.at(gFrameUploadsIndex);
+
+	WaitFence(next_frame_uploads.fence);
+
+	for (auto& page : next_frame_uploads.pages)
+	{
+		page.offset = 0;
+	}
+}
+
+static void DestroyFrameUploads()
+{
+	for (auto& frame_uploads : gFrameUploads)
+	{
+		if (frame_uploads.fence != nullptr)
+			glDeleteSync(frame_uploads.fence);
+
+		for (const auto& page : frame_uploads.pages)
+		{
+			glDeleteBuffers(1, &page.buffer);
+		}
+
+		frame_uploads = FrameUploadsGL();
+	}
+
+	gFrameUploadsIndex = 0;
+}
+
+static void CopyBufferSubData(GLuint src_buffer, size_t src_offset, GLuint dst_buffer, size_t dst_offset, size_t size)
+{
+	if (gDirectStateAccessEnabled)
+	{
+		glCopyNamedBufferSubData(src_buffer, dst_buffer, (GLintptr)src_offset, (GLintptr)dst_offset, (GLsizeiptr)size);
+		return;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, src_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, dst_buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)src_offset, (GLintptr)dst_offset,
+		(GLsizeiptr)size);
+}
+#endif
+
 class BufferGL
 {
 public:
 	auto getGLBuffer() const { return mBuffer; }
+	auto getSize() const { return mSize; }
 
 private:
 	GLuint mBuffer = 0;
 	GLenum mType = 0;
 	size_t mSize = 0;
-	std::unique_ptr<uint8_t[]> mStagingBuffer;
 
 public:
-	BufferGL(size_t size, GLenum type) : mType(type), mSize(size), mStagingBuffer(std::make_unique<uint8_t[]>(size))
+	BufferGL(size_t size, GLenum type) : mType(type), mSize(size)
 	{
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gBufferStorageEnabled)
+		{
+			// immutable storage of the exact size, it is only written by copies from frame upload memory
+			if (gDirectStateAccessEnabled)
+			{
+				glCreateBuffers(1, &mBuffer);
+				glNamedBufferStorage(mBuffer, (GLsizeiptr)size, NULL, 0);
+				return;
+			}
+
+			glGenBuffers(1, &mBuffer);
+			glBindBuffer(type, mBuffer);
+			glBufferStorage(type, (GLsizeiptr)size, NULL, 0);
+			return;
+		}
+#endif
+
 		glGenBuffers(1, &mBuffer);
 		glBindBuffer(type, mBuffer);
 		glBufferData(type, size, NULL, GL_DYNAMIC_DRAW);
@@ -571,16 +1090,20 @@ public:
 	void write(const void* memory, size_t size)
 	{
 		assert(mSize >= size);
-		glBindBuffer(mType, mBuffer);
-		if (size == mSize)
-		{
-			glBufferData(mType, size, memory, GL_DYNAMIC_DRAW);
-		}
-		else
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gBufferStorageEnabled)
 		{
-			memcpy(mStagingBuffer.get(), memory, size);
-			glBufferData(mType, mSize, mStagingBuffer.get(), GL_DYNAMIC_DRAW);
+			// the copy is ordered after the draws that read the old contents on the gpu, the cpu never waits
+			auto [buffer, offset, memory_ptr] = AllocateFrameUploadMemory(size);
+			memcpy(memory_ptr, memory, size);
+			CopyBufferSubData(buffer, offset, mBuffer, 0, size);
+			return;
 		}
+#endif
+
+		glBindBuffer(mType, mBuffer);
+		glBufferSubData(mType, 0, size, memory);
 	}
 };
 
@@ -614,17 +1137,89 @@ public:
 		mStride(stride)
 	{
 	}
-};
+};
+
+static const size_t PushConstantsBufferSize = 256;
+
+class UniformBufferGL;
+
+// uniform buffers bound from frame upload memory, their contents are copied into the buffers when the frame ends
+static std::vector<UniformBufferGL*> gUniformBuffersWithFrameUploads;
+
+class UniformBufferGL : public BufferGL
+{
+public:
+	auto getBindBuffer() const { return mFrameUpload.has_value() ? mFrameUpload->buffer : getGLBuffer(); }
+	auto getBindOffset() const { return mFrameUpload.has_value() ? mFrameUpload->offset : 0; }
+
+private:
+	struct FrameUpload
+	{
+		GLuint buffer;
+		size_t offset;
+	};
+
+private:
+	std::optional<FrameUpload> mFrameUpload;
+
+public:
+	UniformBufferGL(size_t size) : BufferGL(size, GL_UNIFORM_BUFFER)
+	{
+		assert(size % 16 == 0);
+	}
+
+	~UniformBufferGL()
+	{
+		if (mFrameUpload.has_value())
+			std::erase(gUniformBuffersWithFrameUploads, this);
+	}
+
+	void write(const void* memory, size_t size)
+	{
+		assert(getSize() >= size);
+
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		if (gBufferStorageEnabled)
+		{
+			// the new contents are bound from frame upload memory, so the draws before the write keep
+			// reading the old ones and nothing has to be ordered between them
+			auto [buffer, offset, memory_ptr] = AllocateFrameUploadMemory(getSize());
+			memcpy(memory_ptr, memory, size);
+
+			// a partial write keeps the rest of the current contents
+			if (size < getSize())
+				CopyBufferSubData(getBindBuffer(), getBindOffset() + size, buffer, offset + size, getSize() - size);
+
+			if (!mFrameUpload.has_value())
+				gUniformBuffersWithFrameUploads.push_back(this);
+
+			mFrameUpload = FrameUpload{
+				.buffer = buffer,
+				.offset = offset
+			};
+			return;
+		}
+#endif
+
+		BufferGL::write(memory, size);
+	}
 
-class UniformBufferGL : public BufferGL
-{
-public:
-	UniformBufferGL(size_t size) : BufferGL(size, GL_UNIFORM_BUFFER)
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+	void resolveFrameUpload()
 	{
-		assert(size % 16 == 0);
+		assert(mFrameUpload.has_value());
+		CopyBufferSubData(mFrameUpload->buffer, mFrameUpload->offset, getGLBuffer(), 0, getSize());
+		mFrameUpload.reset();
 	}
+#endif
 };
 
+static void BindUniformBuffer(uint32_t binding, const UniformBufferGL& buffer)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer.getBindBuffer(), (GLintptr)buffer.getBindOffset(),
+		(GLsizeiptr)buffer.getSize());
+}
+
 struct SamplerStateGL
 {
 	Sampler sampler = Sampler::Linear;
@@ -640,6 +1235,47 @@ SKYGFX_MAKE_HASHABLE(SamplerStateGL,
 	t.anisotropy_level
 );
 
+struct MipmapProgramStateGL
+{
+	PixelFormat format;
+	MipmapFilter filter;
+
+	bool operator==(const MipmapProgramStateGL& other) const = default;
+};
+
+SKYGFX_MAKE_HASHABLE(MipmapProgramStateGL,
+	t.format,
+	t.filter
+);
+
+struct VertexArrayStateGL
+{
+	struct VertexBuffer
+	{
+		GLuint buffer = 0;
+		size_t stride = 0;
+
+		bool operator==(const VertexBuffer& other) const = default;
+	};
+
+	std::vector<InputLayout> input_layouts;
+	std::vector<VertexBuffer> vertex_buffers;
+	GLuint index_buffer = 0;
+
+	bool operator==(const VertexArrayStateGL& other) const = default;
+};
+
+SKYGFX_MAKE_HASHABLE(VertexArrayStateGL::VertexBuffer,
+	t.buffer,
+	t.stride
+);
+
+SKYGFX_MAKE_HASHABLE(VertexArrayStateGL,
+	t.input_layouts,
+	t.vertex_buffers,
+	t.index_buffer
+);
+
 #if defined(SKYGFX_PLATFORM_WINDOWS)
 static HGLRC WglContext;
 static HDC gHDC;
@@ -655,12 +1291,23 @@ EGLContext gEglContext;
 EGLConfig gEglConfig;
 #endif
 
+#if defined(SKYGFX_PLATFORM_IOS)
+static void SyncDrawableFramebuffer()
+{
+	// the drawable framebuffer is created by GLKView, its name is only known by querying it
+	GLint framebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+	gBindings.framebuffer = framebuffer;
+}
+#endif
+
 struct ContextGL
 {
 	ContextGL()
 	{
 		glGenVertexArrays(1, &vao);
 		glBindVertexArray(vao);
+		current_vertex_array = vao;
 
 		glGenBuffers(1, &pixel_buffer);
 
@@ -673,13 +1320,26 @@ struct ContextGL
 		}
 
 		glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_vertex_attribs);
+
+		// texture readback expects tightly packed rows
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+		push_constants_buffer = std::make_unique<UniformBufferGL>(PushConstantsBufferSize);
 	}
 
 	~ContextGL()
 	{
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+		DestroyFrameUploads();
+#endif
 		glDeleteVertexArrays(1, &vao);
 		glDeleteBuffers(1, &pixel_buffer);
 
+		for (const auto& [state, vertex_array] : vertex_arrays)
+		{
+			glDeleteVertexArrays(1, &vertex_array);
+		}
+
 		for (const auto& [state, objects_map] : sampler_states)
 		{
 			for (const auto& [type, object] : objects_map)
@@ -687,6 +1347,11 @@ struct ContextGL
 				glDeleteSamplers(1, &object);
 			}
 		}
+
+		for (const auto& [state, program] : mipmap_programs)
+		{
+			glDeleteProgram(program);
+		}
 	}
 
 	int max_vertex_attribs;
@@ -700,9 +1365,18 @@ struct ContextGL
 	bool has_anisotropy_extension = false;
 #endif
 
+	bool program_binary_supported = false;
+	std::string driver_identity;
+	std::optional<std::filesystem::path> shader_cache_directory;
+
+	bool has_nvx_gpu_memory_info = false;
+	bool has_ati_meminfo = false;
+	MemoryStats memory_stats;
+
 	ExecuteList execute_after_present;
 
 	std::unordered_map<uint32_t, TextureGL*> textures;
+	std::unordered_map<uint32_t, UniformBufferGL*> uniform_buffers;
 	std::unordered_set<uint32_t> dirty_textures;
 
 	enum class SamplerType
@@ -716,8 +1390,16 @@ struct ContextGL
 
 	std::vector<RenderTargetGL*> render_targets;
 
+	std::unordered_map<MipmapProgramStateGL, GLuint> mipmap_programs;
+	std::unique_ptr<UniformBufferGL> mipmap_settings_buffer;
+
 	GLuint pixel_buffer;
-	GLuint vao;
+	GLuint vao; // bound while index buffers are created or written, so cached vertex arrays stay untouched
+
+	std::unordered_map<VertexArrayStateGL, GLuint> vertex_arrays;
+	GLuint current_vertex_array = 0;
+
+	std::unique_ptr<UniformBufferGL> push_constants_buffer;
 
 	GLenum topology;
 	ShaderGL* shader = nullptr;
@@ -746,6 +1428,73 @@ struct ContextGL
 
 static ContextGL* gContext = nullptr;
 
+static void AddMemoryUsage(MemoryStats::Category& category, uint64_t size)
+{
+	category.size += size;
+	category.peak_size = std::max(category.peak_size, category.size);
+}
+
+static void RemoveMemoryUsage(MemoryStats::Category& category, uint64_t size)
+{
+	assert(category.size >= size);
+	category.size -= size;
+}
+
+static uint64_t GetTextureMemorySize(const TextureGL& texture)
+{
+	// the driver does not tell the real size, this is what the pixels take without padding
+	uint64_t pixel_size = GetFormatChannelsCount(texture.getFormat()) * GetFormatChannelSize(texture.getFormat());
+	uint64_t size = 0;
+
+	for (uint32_t i = 0; i < texture.getMipCount(); i++)
+	{
+		size += (uint64_t)GetMipWidth(texture.getWidth(), i) * GetMipHeight(texture.getHeight(), i) * pixel_size;
+	}
+
+	return size;
+}
+
+static uint64_t GetRenderTargetMemorySize(const RenderTargetGL& render_target)
+{
+	// GL_DEPTH24_STENCIL8
+	return (uint64_t)render_target.getTexture()->getWidth() * render_target.getTexture()->getHeight() * 4;
+}
+
+static MemoryStats GetMemoryStats()
+{
+	auto stats = gContext->memory_stats;
+
+	// both extensions report kilobytes of the dedicated video memory
+
+	if (gContext->has_nvx_gpu_memory_info)
+	{
+		GLint total_memory = 0;
+		GLint available_memory = 0;
+		glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total_memory);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available_memory);
+
+		MemoryStats::Heap heap;
+		heap.device_local = true;
+		heap.budget = (uint64_t)total_memory * 1024;
+		heap.usage = (uint64_t)(total_memory - available_memory) * 1024;
+		stats.heaps.push_back(heap);
+	}
+	else if (gContext->has_ati_meminfo)
+	{
+		// only the free memory is known, so the usage is what was allocated through skygfx
+		GLint free_memory[4] = { 0 };
+		glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, free_memory);
+
+		MemoryStats::Heap heap;
+		heap.device_local = true;
+		heap.usage = stats.textures.size + stats.buffers.size + stats.render_targets.size;
+		heap.budget = heap.usage + (uint64_t)free_memory[0] * 1024;
+		stats.heaps.push_back(heap);
+	}
+
+	return stats;
+}
+
 uint32_t ContextGL::getBackbufferWidth()
 {
 	return !render_targets.empty() ? render_targets.at(0)->getTexture()->getWidth() : width;
@@ -761,6 +1510,118 @@ PixelFormat ContextGL::getBackbufferFormat()
 	return !render_targets.empty() ? render_targets.at(0)->getTexture()->getFormat() : PixelFormat::RGBA8UNorm;
 }
 
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+static GLuint GetMipmapProgram(PixelFormat format, MipmapFilter filter)
+{
+	auto program_state = MipmapProgramStateGL{
+		.format = format,
+		.filter = filter
+	};
+
+	if (gContext->mipmap_programs.contains(program_state))
+		return gContext->mipmap_programs.at(program_state);
+
+	auto defines = GetMipmapComputeShaderDefines(format, filter).value();
+	auto spirv = CompileGlslToSpirv(ShaderStage::Compute, MipmapComputeShaderCode, defines);
+	auto glsl = CompileSpirvToGlsl(spirv, false, 430, true, false);
+
+	auto throw_error = [](auto shader, auto get_length_func, auto get_info_log_func) {
+		GLint length = 0;
+		get_length_func(shader, GL_INFO_LOG_LENGTH, &length);
+		std::string str;
+		str.resize(length);
+		get_info_log_func(shader, length, &length, &str[0]);
+		throw std::runtime_error(str);
+	};
+
+	auto shader = glCreateShader(GL_COMPUTE_SHADER);
+	auto v = glsl.c_str();
+	glShaderSource(shader, 1, &v, NULL);
+	glCompileShader(shader);
+
+	GLint compile_status = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+
+	if (compile_status == GL_FALSE)
+		throw_error(shader, glGetShaderiv, glGetShaderInfoLog);
+
+	auto program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+
+	GLint link_status = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+
+	if (link_status == GL_FALSE)
+		throw_error(program, glGetProgramiv, glGetProgramInfoLog);
+
+	glDeleteShader(shader);
+
+	gContext->mipmap_programs.insert({ program_state, program });
+
+	return program;
+}
+
+static bool GenerateMipsWithCompute(TextureGL* texture, MipmapFilter filter)
+{
+	if (!GLEW_VERSION_4_3)
+		return false;
+
+	auto format = texture->getFormat();
+
+	if (!GetMipmapComputeShaderDefines(format, filter).has_value())
+		return false;
+
+	auto program = GetMipmapProgram(format, filter);
+	auto internal_format = TextureInternalFormatMap.at(format);
+	auto width = texture->getWidth();
+	auto height = texture->getHeight();
+
+	if (gContext->mipmap_settings_buffer == nullptr)
+		gContext->mipmap_settings_buffer = std::make_unique<UniformBufferGL>(PushConstantsBufferSize);
+
+	const auto& settings_buffer = gContext->mipmap_settings_buffer;
+
+	UseProgram(program);
+
+	for (const auto& pass : MakeMipmapComputePasses(width, height, texture->getMipCount(), filter))
+	{
+		glBindImageTexture(0, texture->getGLTexture(), pass.src_mip_level, GL_FALSE, 0, GL_READ_ONLY, internal_format);
+
+		// units beyond the pass are not written by the shader, but still must be valid
+		for (uint32_t i = 0; i < MipmapComputeMaxMipsPerPass; i++)
+		{
+			auto mip_level = pass.src_mip_level + 1 + std::min(i, pass.mip_count - 1);
+			glBindImageTexture(i + 1, texture->getGLTexture(), mip_level, GL_FALSE, 0, GL_WRITE_ONLY, internal_format);
+		}
+
+		auto settings = MipmapComputeSettings{
+			.src_size = {
+				(int32_t)GetMipWidth(width, pass.src_mip_level),
+				(int32_t)GetMipHeight(height, pass.src_mip_level)
+			},
+			.mip_count = (int32_t)pass.mip_count
+		};
+
+		settings_buffer->write(&settings, sizeof(settings));
+		BindUniformBuffer(PushConstantsBinding, *settings_buffer);
+		glDispatchCompute(pass.group_count_x, pass.group_count_y, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+
+	BindUniformBuffer(PushConstantsBinding, *gContext->push_constants_buffer);
+
+	if (gContext->shader != nullptr)
+		gContext->shader_dirty = true;
+	else
+		UseProgram(0);
+
+	return true;
+}
+#endif
+
 static void EnsureScissor()
 {
 	if (!gContext->scissor_dirty)
@@ -806,66 +1667,119 @@ static void EnsureDepthMode()
 	glDepthMask(depth_mode->write_mask);
 }
 
-static void EnsureGraphicsState(bool draw_indexed)
+static GLuint GetVertexArray()
 {
-	if (gContext->shader_dirty)
-	{
-		glUseProgram(gContext->shader->getProgram());
-		gContext->vertex_array_dirty = true;
-		gContext->index_buffer_dirty = draw_indexed;
-		gContext->shader_dirty = false;
-	}
+	VertexArrayStateGL state;
+	state.input_layouts = gContext->input_layouts;
 
-	if (gContext->index_buffer_dirty && draw_indexed)
+	for (auto vertex_buffer : gContext->vertex_buffers)
 	{
-		gContext->index_buffer_dirty = false;
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gContext->index_buffer->getGLBuffer());
+		state.vertex_buffers.push_back({
+			.buffer = vertex_buffer->getGLBuffer(),
+			.stride = vertex_buffer->getStride()
+		});
 	}
 
-	if (gContext->vertex_array_dirty)
+	if (gContext->index_buffer != nullptr)
+		state.index_buffer = gContext->index_buffer->getGLBuffer();
+
+	if (gContext->vertex_arrays.contains(state))
+		return gContext->vertex_arrays.at(state);
+
+	GLuint vertex_array;
+	glGenVertexArrays(1, &vertex_array);
+	glBindVertexArray(vertex_array);
+	gContext->current_vertex_array = vertex_array;
+
+	for (size_t i = 0; i < state.vertex_buffers.size(); i++)
 	{
-		gContext->vertex_array_dirty = false;
+		const auto& vertex_buffer = state.vertex_buffers.at(i);
+		auto stride = (GLsizei)vertex_buffer.stride;
+
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.buffer);
 
-		std::unordered_set<uint32_t> active_locations;
+		const auto& input_layout = state.input_layouts.at(i);
 
-		for (size_t i = 0; i < gContext->vertex_buffers.size(); i++)
+		for (const auto& [location, attribute] : input_layout.attributes)
 		{
-			auto vertex_buffer = gContext->vertex_buffers.at(i);
-			auto stride = (GLsizei)vertex_buffer->getStride();
+			auto index = (GLuint)location;
+			auto size = (GLint)VertexFormatSizeMap.at(attribute.format);
+			auto type = (GLenum)VertexFormatTypeMap.at(attribute.format);
+			auto normalized = (GLboolean)VertexFormatNormalizeMap.at(attribute.format);
+			auto pointer = (void*)attribute.offset;
+			glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+			glVertexAttribDivisor(index, input_layout.rate == InputLayout::Rate::Vertex ? 0 : 1);
+			glEnableVertexAttribArray(index);
+		}
+	}
 
-			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer->getGLBuffer());
+	if (state.index_buffer != 0)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state.index_buffer);
 
-			const auto& input_layout = gContext->input_layouts.at(i);
+	gContext->vertex_arrays.insert({ state, vertex_array });
+	return vertex_array;
+}
 
-			for (const auto& [location, attribute] : input_layout.attributes)
-			{
-				active_locations.insert(location);
-
-				auto index = (GLuint)location;
-				auto size = (GLint)VertexFormatSizeMap.at(attribute.format);
-				auto type = (GLenum)VertexFormatTypeMap.at(attribute.format);
-				auto normalized = (GLboolean)VertexFormatNormalizeMap.at(attribute.format);
-				auto pointer = (void*)attribute.offset;
-				glVertexAttribPointer(index, size, type, normalized, stride, pointer);
-				glVertexAttribDivisor(index, input_layout.rate == InputLayout::Rate::Vertex ? 0 : 1);
-			}
-		}
+static void BindVertexArray(GLuint vertex_array)
+{
+	if (gContext->current_vertex_array == vertex_array)
+		return;
+
+	glBindVertexArray(vertex_array);
+	gContext->current_vertex_array = vertex_array;
+}
+
+static void BindScratchVertexArray()
+{
+	if (gContext->current_vertex_array == gContext->vao)
+		return;
+
+	BindVertexArray(gContext->vao);
+	gContext->vertex_array_dirty = true;
+}
+
+static void DestroyVertexArrays(GLuint buffer)
+{
+	std::erase_if(gContext->vertex_arrays, [buffer](const auto& pair) {
+		const auto& [state, vertex_array] = pair;
 
-		for (int i = 0; i < gContext->max_vertex_attribs; i++)
+		auto uses_buffer = state.index_buffer == buffer || std::ranges::any_of(state.vertex_buffers,
+			[buffer](const auto& vertex_buffer) { return vertex_buffer.buffer == buffer; });
+
+		if (!uses_buffer)
+			return false;
+
+		if (gContext->current_vertex_array == vertex_array)
 		{
-			if (active_locations.contains(i))
-				glEnableVertexAttribArray(i);
-			else
-				glDisableVertexAttribArray(i);
+			gContext->current_vertex_array = 0;
+			gContext->vertex_array_dirty = true;
 		}
+
+		glDeleteVertexArrays(1, &vertex_array);
+		return true;
+	});
+}
+
+static void EnsureGraphicsState()
+{
+	if (gContext->shader_dirty)
+	{
+		UseProgram(gContext->shader->getProgram());
+		gContext->shader_dirty = false;
+	}
+
+	if (gContext->vertex_array_dirty || gContext->index_buffer_dirty)
+	{
+		gContext->vertex_array_dirty = false;
+		gContext->index_buffer_dirty = false;
+		BindVertexArray(GetVertexArray());
 	}
 
 	for (auto binding : gContext->dirty_textures)
 	{
 		auto texture = gContext->textures.at(binding);
 
-		glActiveTexture(GL_TEXTURE0 + binding);
-		glBindTexture(GL_TEXTURE_2D, texture->getGLTexture());
+		BindTexture(binding, texture->getGLTexture());
 	}
 
 	gContext->dirty_textures.clear();
@@ -1175,6 +2089,17 @@ BackendGL::BackendGL(void* window, uint32_t width, uint32_t height, Adapter adap
 	//	std::cout << extension << std::endl;
 	}
 
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+	gBufferStorageEnabled = GLEW_VERSION_4_4 || extensions.contains("GL_ARB_buffer_storage");
+	gDirectStateAccessEnabled = GLEW_VERSION_4_5 || extensions.contains("GL_ARB_direct_state_access");
+#endif
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gUniformBufferOffsetAlignment);
+
+	gBindings = {};
+#if defined(SKYGFX_PLATFORM_IOS)
+	SyncDrawableFramebuffer();
+#endif
+
 	gContext = new ContextGL();
 
 	gContext->width = width;
@@ -1183,6 +2108,20 @@ BackendGL::BackendGL(void* window, uint32_t width, uint32_t height, Adapter adap
 #if defined(SKYGFX_PLATFORM_EMSCRIPTEN)
 	gContext->has_anisotropy_extension = extensions.contains("GL_EXT_texture_filter_anisotropic");
 #endif
+
+#if !defined(SKYGFX_PLATFORM_EMSCRIPTEN)
+	GLint num_program_binary_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_program_binary_formats);
+	gContext->program_binary_supported = num_program_binary_formats > 0;
+#endif
+
+	for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		gContext->driver_identity += (const char*)glGetString(name);
+	}
+
+	gContext->has_nvx_gpu_memory_info = extensions.contains("GL_NVX_gpu_memory_info");
+	gContext->has_ati_meminfo = extensions.contains("GL_ATI_meminfo");
 }
 
 BackendGL::~BackendGL()
@@ -1213,6 +2152,10 @@ void BackendGL::setVsync(bool value)
 #endif
 }
 
+void BackendGL::setFramesInFlight(uint32_t count)
+{
+}
+
 void BackendGL::setTopology(Topology topology)
 {
 	static const std::unordered_map<Topology, GLenum> TopologyMap = {
@@ -1250,9 +2193,10 @@ void BackendGL::setRenderTarget(const RenderTarget** render_target, size_t count
 	if (count == 0)
 	{
 #if defined(SKYGFX_PLATFORM_WINDOWS) | defined(SKYGFX_PLATFORM_MACOS) | defined(SKYGFX_PLATFORM_EMSCRIPTEN)
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		BindFramebuffer(0);
 #elif defined(SKYGFX_PLATFORM_IOS)
 		[gGLKView bindDrawable];
+		SyncDrawableFramebuffer();
 #endif
 		gContext->render_targets.clear();
 
@@ -1269,7 +2213,7 @@ void BackendGL::setRenderTarget(const RenderTarget** render_target, size_t count
 		render_targets.push_back(target);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, render_targets.at(0)->getGLFramebuffer());
+	BindFramebuffer(render_targets.at(0)->getGLFramebuffer());
 
 	for (size_t i = 0; i < render_targets.size(); i++)
 	{
@@ -1322,7 +2266,38 @@ void BackendGL::setIndexBuffer(IndexBufferHandle* handle)
 void BackendGL::setUniformBuffer(uint32_t binding, UniformBufferHandle* handle)
 {
 	auto buffer = (UniformBufferGL*)handle;
-	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer->getGLBuffer());
+	BindUniformBuffer(binding, *buffer);
+	gContext->uniform_buffers[binding] = buffer;
+}
+
+void BackendGL::setPushConstants(const void* memory, size_t size)
+{
+	assert(size <= PushConstantsBufferSize);
+
+	const auto& buffer = gContext->push_constants_buffer;
+	buffer->write(memory, size);
+	BindUniformBuffer(PushConstantsBinding, *buffer);
+}
+
+void BackendGL::setAsyncPipelineCompilation(bool value)
+{
+}
+
+uint32_t BackendGL::getPendingPipelinesCount()
+{
+	return 0;
+}
+
+MemoryStats BackendGL::getMemoryStats()
+{
+	return GetMemoryStats();
+}
+
+void BackendGL::setShaderCacheDirectory(const std::string& path)
+{
+	std::error_code error_code;
+	std::filesystem::create_directories(path, error_code);
+	gContext->shader_cache_directory = path;
 }
 
 void BackendGL::setBlendMode(const std::optional<BlendMode>& blend_mode)
@@ -1451,6 +2426,10 @@ void BackendGL::setDepthBias(const std::optional<DepthBias> depth_bias)
 	glPolygonOffset(depth_bias->factor, depth_bias->units);
 }
 
+void BackendGL::setStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+}
+
 void BackendGL::clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
@@ -1502,7 +2481,7 @@ void BackendGL::clear(const std::optional<glm::vec4>& color, const std::optional
 
 void BackendGL::draw(uint32_t vertex_count, uint32_t vertex_offset, uint32_t instance_count)
 {
-	EnsureGraphicsState(false);
+	EnsureGraphicsState();
 	auto mode = gContext->topology;
 	auto first = (GLint)vertex_offset;
 	auto count = (GLsizei)vertex_count;
@@ -1512,7 +2491,7 @@ void BackendGL::draw(uint32_t vertex_count, uint32_t vertex_offset, uint32_t ins
 
 void BackendGL::drawIndexed(uint32_t index_count, uint32_t index_offset, uint32_t instance_count)
 {
-	EnsureGraphicsState(true);
+	EnsureGraphicsState();
 	auto mode = gContext->topology;
 	auto count = (GLsizei)index_count;
 	auto index_size = gContext->index_buffer->getStride();
@@ -1538,16 +2517,48 @@ void BackendGL::copyBackbufferToTexture(const glm::i32vec2& src_pos, const glm::
 
 	auto y = backbuffer_height - src_pos.y - size.y;
 
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+	if (gDirectStateAccessEnabled)
+	{
+		glCopyTextureSubImage2D(dst_texture->getGLTexture(), 0, dst_pos.x, dst_pos.y, src_pos.x, y, size.x, size.y);
+		return;
+	}
+#endif
+
 	TextureGL::ScopedBind binding(dst_texture->getGLTexture());
 	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, dst_pos.x, dst_pos.y, src_pos.x, y, size.x, size.y);
 }
 
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+static void ResolveFrameUploads()
+{
+	if (gUniformBuffersWithFrameUploads.empty())
+		return;
+
+	for (auto buffer : gUniformBuffersWithFrameUploads)
+	{
+		buffer->resolveFrameUpload();
+	}
+
+	gUniformBuffersWithFrameUploads.clear();
+
+	for (const auto& [binding, buffer] : gContext->uniform_buffers)
+	{
+		BindUniformBuffer(binding, *buffer);
+	}
+
+	BindUniformBuffer(PushConstantsBinding, *gContext->push_constants_buffer);
+}
+#endif
+
 void BackendGL::present()
 {
 #ifdef SKYGFX_OPENGL_VALIDATION_ENABLED
 	FlushErrors();
 #endif
 #if defined(SKYGFX_PLATFORM_WINDOWS)
+	ResolveFrameUploads();
+	AdvanceFrameUploads();
 	SwapBuffers(gHDC);
 #elif defined(SKYGFX_PLATFORM_IOS)
 	[gGLKView display];
@@ -1563,6 +2574,7 @@ TextureHandle* BackendGL::createTexture(uint32_t width, uint32_t height, PixelFo
 	uint32_t mip_count)
 {
 	auto texture = new TextureGL(width, height, format, mip_count);
+	AddMemoryUsage(gContext->memory_stats.textures, GetTextureMemorySize(*texture));
 	return (TextureHandle*)texture;
 }
 
@@ -1570,7 +2582,7 @@ void BackendGL::writeTexturePixels(TextureHandle* handle, uint32_t width, uint32
 	uint32_t mip_level, uint32_t offset_x, uint32_t offset_y)
 {
 	auto texture = (TextureGL*)handle;
-	texture->write(width, height, memory, mip_level, offset_x, offset_y);
+	texture->write(width, height, memory, mip_level, offset_x, offset_y, gContext->pixel_buffer);
 }
 
 std::vector<uint8_t> BackendGL::readTexturePixels(TextureHandle* handle, uint32_t mip_level)
@@ -1579,15 +2591,20 @@ std::vector<uint8_t> BackendGL::readTexturePixels(TextureHandle* handle, uint32_
 	return texture->read(mip_level);
 }
 
-void BackendGL::generateMips(TextureHandle* handle)
+void BackendGL::generateMips(TextureHandle* handle, MipmapFilter filter)
 {
 	auto texture = (TextureGL*)handle;
+#if defined(SKYGFX_PLATFORM_WINDOWS)
+	if (GenerateMipsWithCompute(texture, filter))
+		return;
+#endif
 	texture->generateMips();
 }
 
 void BackendGL::destroyTexture(TextureHandle* handle)
 {
 	auto texture = (TextureGL*)handle;
+	RemoveMemoryUsage(gContext->memory_stats.textures, GetTextureMemorySize(*texture));
 	delete texture;
 }
 
@@ -1595,19 +2612,47 @@ RenderTargetHandle* BackendGL::createRenderTarget(uint32_t width, uint32_t heigh
 {
 	auto texture = (TextureGL*)texture_handle;
 	auto render_target = new RenderTargetGL(texture);
+	AddMemoryUsage(gContext->memory_stats.render_targets, GetRenderTargetMemorySize(*render_target));
 	return (RenderTargetHandle*)render_target;
 }
 
 void BackendGL::destroyRenderTarget(RenderTargetHandle* handle)
 {
 	auto render_target = (RenderTargetGL*)handle;
+	RemoveMemoryUsage(gContext->memory_stats.render_targets, GetRenderTargetMemorySize(*render_target));
 	delete render_target;
 }
 
+static std::optional<ProgramBinaryCacheEntryGL> GetProgramBinaryCacheEntry(const std::string& vertex_code,
+	const std::string& fragment_code, const std::vector<std::string>& defines)
+{
+	if (!gContext->program_binary_supported || !gContext->shader_cache_directory.has_value())
+		return std::nullopt;
+
+	// the full key is stored in the file and compared on load, the name only has to spread the files
+
+	auto key = gContext->driver_identity + '\0';
+
+	for (const auto& define : defines)
+	{
+		key += define + '\0';
+	}
+
+	key += vertex_code + '\0' + fragment_code;
+
+	auto hash = std::hash<std::string>{}(key);
+
+	return ProgramBinaryCacheEntryGL{
+		.path = gContext->shader_cache_directory.value() / (std::to_string(hash) + ".bin"),
+		.key = std::move(key)
+	};
+}
+
 ShaderHandle* BackendGL::createShader(const std::string& vertex_code,
 	const std::string& fragment_code, const std::vector<std::string>& defines)
 {
-	auto shader = new ShaderGL(vertex_code, fragment_code, defines);
+	auto binary_cache_entry = GetProgramBinaryCacheEntry(vertex_code, fragment_code, defines);
+	auto shader = new ShaderGL(vertex_code, fragment_code, defines, binary_cache_entry);
 	return (ShaderHandle*)shader;
 }
 
@@ -1620,6 +2665,7 @@ void BackendGL::destroyShader(ShaderHandle* handle)
 VertexBufferHandle* BackendGL::createVertexBuffer(size_t size, size_t stride)
 {
 	auto buffer = new VertexBufferGL(size, stride);
+	AddMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 	return (VertexBufferHandle*)buffer;
 }
 
@@ -1627,6 +2673,8 @@ void BackendGL::destroyVertexBuffer(VertexBufferHandle* handle)
 {
 	gContext->execute_after_present.add([handle] {
 		auto buffer = (VertexBufferGL*)handle;
+		DestroyVertexArrays(buffer->getGLBuffer());
+		RemoveMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 		delete buffer;
 	});
 }
@@ -1636,11 +2684,16 @@ void BackendGL::writeVertexBufferMemory(VertexBufferHandle* handle, const void*
 	auto buffer = (VertexBufferGL*)handle;
 	buffer->write(memory, size);
 	buffer->setStride(stride);
+
+	if (std::ranges::find(gContext->vertex_buffers, buffer) != gContext->vertex_buffers.end())
+		gContext->vertex_array_dirty = true;
 }
 
 IndexBufferHandle* BackendGL::createIndexBuffer(size_t size, size_t stride)
 {
+	BindScratchVertexArray();
 	auto buffer = new IndexBufferGL(size, stride);
+	AddMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 	return (IndexBufferHandle*)buffer;
 }
 
@@ -1652,6 +2705,8 @@ void BackendGL::destroyIndexBuffer(IndexBufferHandle* handle)
 		if (gContext->index_buffer == buffer)
 			gContext->index_buffer = nullptr;
 
+		DestroyVertexArrays(buffer->getGLBuffer());
+		RemoveMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 		delete buffer;
 	});
 }
@@ -1659,6 +2714,7 @@ void BackendGL::destroyIndexBuffer(IndexBufferHandle* handle)
 void BackendGL::writeIndexBufferMemory(IndexBufferHandle* handle, const void* memory, size_t size, size_t stride)
 {
 	auto buffer = (IndexBufferGL*)handle;
+	BindScratchVertexArray();
 	buffer->write(memory, size);
 	buffer->setStride(stride);
 }
@@ -1666,6 +2722,7 @@ void BackendGL::writeIndexBufferMemory(IndexBufferHandle* handle, const void* me
 UniformBufferHandle* BackendGL::createUniformBuffer(size_t size)
 {
 	auto buffer = new UniformBufferGL(size);
+	AddMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 	return (UniformBufferHandle*)buffer;
 }
 
@@ -1673,6 +2730,12 @@ void BackendGL::destroyUniformBuffer(UniformBufferHandle* handle)
 {
 	gContext->execute_after_present.add([handle] {
 		auto buffer = (UniformBufferGL*)handle;
+
+		std::erase_if(gContext->uniform_buffers, [buffer](const auto& pair) {
+			return pair.second == buffer;
+		});
+
+		RemoveMemoryUsage(gContext->memory_stats.buffers, buffer->getSize());
 		delete buffer;
 	});
 }
@@ -1681,6 +2744,42 @@ void BackendGL::writeUniformBufferMemory(UniformBufferHandle* handle, const void
 {
 	auto buffer = (UniformBufferGL*)handle;
 	buffer->write(memory, size);
+
+	for (const auto& [binding, uniform_buffer] : gContext->uniform_buffers)
+	{
+		if (uniform_buffer == buffer)
+			BindUniformBuffer(binding, *buffer);
+	}
+}
+
+UploadId BackendGL::writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+	const void* memory, uint32_t mip_level)
+{
+	writeTexturePixels(handle, width, height, memory, mip_level, 0, 0);
+	return 0;
+}
+
+UploadId BackendGL::writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeVertexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+UploadId BackendGL::writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	writeIndexBufferMemory(handle, memory, size, stride);
+	return 0;
+}
+
+bool BackendGL::isUploadCompleted(UploadId id)
+{
+	return true;
+}
+
+void BackendGL::waitUpload(UploadId id)
+{
 }
 
 #endif
@@ -14,6 +14,7 @@ namespace skygfx
 
 		void resize(uint32_t width, uint32_t height) override;
 		void setVsync(bool value) override;
+		void setFramesInFlight(uint32_t count) override;
 
 		void setTopology(Topology topology) override;
 		void setViewport(std::optional<Viewport> viewport) override;
@@ -25,6 +26,11 @@ namespace skygfx
 		void setVertexBuffer(const VertexBuffer** vertex_buffer, size_t count) override;
 		void setIndexBuffer(IndexBufferHandle* handle) override;
 		void setUniformBuffer(uint32_t binding, UniformBufferHandle* handle) override;
+		void setPushConstants(const void* memory, size_t size) override;
+		void setAsyncPipelineCompilation(bool value) override;
+		uint32_t getPendingPipelinesCount() override;
+		MemoryStats getMemoryStats() override;
+		void setShaderCacheDirectory(const std::string& path) override;
 		void setBlendMode(const std::optional<BlendMode>& blend_mode) override;
 		void setDepthMode(const std::optional<DepthMode>& depth_mode) override;
 		void setStencilMode(const std::optional<StencilMode>& stencil_mode) override;
@@ -34,6 +40,7 @@ namespace skygfx
 		void setTextureAddress(TextureAddress value) override;
 		void setFrontFace(FrontFace value) override;
 		void setDepthBias(const std::optional<DepthBias> depth_bias) override;
+		void setStoreAction(StoreAction color, StoreAction depth_stencil) override;
 
 		void clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 			const std::optional<uint8_t>& stencil) override;
@@ -50,7 +57,7 @@ namespace skygfx
 		void writeTexturePixels(TextureHandle* handle, uint32_t width, uint32_t height, const void* memory,
 			uint32_t mip_level, uint32_t offset_x, uint32_t offset_y) override;
 		std::vector<uint8_t> readTexturePixels(TextureHandle* handle, uint32_t mip_level) override;
-		void generateMips(TextureHandle* handle) override;
+		void generateMips(TextureHandle* handle, MipmapFilter filter) override;
 		void destroyTexture(TextureHandle* handle) override;
 
 		RenderTargetHandle* createRenderTarget(uint32_t width, uint32_t height, TextureHandle* texture) override;
@@ -71,6 +78,15 @@ namespace skygfx
 		UniformBufferHandle* createUniformBuffer(size_t size) override;
 		void destroyUniformBuffer(UniformBufferHandle* handle) override;
 		void writeUniformBufferMemory(UniformBufferHandle* handle, const void* memory, size_t size) override;
+
+		UploadId writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+			const void* memory, uint32_t mip_level) override;
+		UploadId writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) override;
+		UploadId writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) override;
+		bool isUploadCompleted(UploadId id) override;
+		void waitUpload(UploadId id) override;
 	};
 }
 
@@ -85,6 +85,7 @@ struct ContextMTL
 	BufferMetal* vertex_buffer = nullptr;
 	std::unordered_map<uint32_t, BufferMetal*> uniform_buffers;
 	std::unordered_map<uint32_t, TextureMetal*> textures;
+	std::vector<uint8_t> push_constants;
 
 	bool pipeline_state_dirty = true;
 	bool cull_mode_dirty = true;
@@ -153,12 +154,14 @@ class ShaderMetal
 public:
 	auto getMetalVertFunc() const { return mVertFunc; }
 	auto getMetalFragFunc() const { return mFragFunc; }
+	auto getPushConstantsSize() const { return mPushConstantsSize; }
 
 private:
 	id<MTLLibrary> mVertLib = nullptr;
 	id<MTLLibrary> mFragLib = nullptr;
 	id<MTLFunction> mVertFunc = nullptr;
 	id<MTLFunction> mFragFunc = nullptr;
+	uint32_t mPushConstantsSize = 0;
 
 public:
 	ShaderMetal(const std::string& vertex_code, const std::string& fragment_code,
@@ -167,6 +170,14 @@ public:
 		auto vertex_shader_spirv = CompileGlslToSpirv(ShaderStage::Vertex, vertex_code, defines);
 		auto fragment_shader_spirv = CompileGlslToSpirv(ShaderStage::Fragment, fragment_code, defines);
 
+		for (const auto& spirv : { vertex_shader_spirv, fragment_shader_spirv })
+		{
+			auto reflection = MakeSpirvReflection(spirv);
+
+			if (reflection.push_constants.has_value())
+				mPushConstantsSize = std::max(mPushConstantsSize, reflection.push_constants->size);
+		}
+
 		auto msl_vert = CompileSpirvToMsl(vertex_shader_spirv);
 		auto msl_frag = CompileSpirvToMsl(fragment_shader_spirv);
 
@@ -820,6 +831,20 @@ static void EnsureGraphicsDescriptors()
 		[gContext->render_command_encoder setVertexBuffer:buffer->getMetalBuffer() offset:0 atIndex:binding];
 		[gContext->render_command_encoder setFragmentBuffer:buffer->getMetalBuffer() offset:0 atIndex:binding];
 	}
+
+	auto push_constants_size = gContext->pipeline_state.shader->getPushConstantsSize();
+
+	if (push_constants_size > 0)
+	{
+		// the shader reads its whole block, the part that was not set reads as zeros
+		if (gContext->push_constants.size() < push_constants_size)
+			gContext->push_constants.resize(push_constants_size, 0);
+
+		[gContext->render_command_encoder setVertexBytes:gContext->push_constants.data()
+			length:push_constants_size atIndex:PushConstantsBinding];
+		[gContext->render_command_encoder setFragmentBytes:gContext->push_constants.data()
+			length:push_constants_size atIndex:PushConstantsBinding];
+	}
 }
 
 static void EnsureDepthStencilState()
@@ -959,6 +984,10 @@ void BackendMetal::setVsync(bool value)
 {
 }
 
+void BackendMetal::setFramesInFlight(uint32_t count)
+{
+}
+
 void BackendMetal::setTopology(Topology topology)
 {
 	const static std::unordered_map<Topology, MTLPrimitiveType> TopologyMap = {
@@ -1079,6 +1108,29 @@ void BackendMetal::setUniformBuffer(uint32_t binding, UniformBufferHandle* handl
 	gContext->uniform_buffers[binding] = buffer;
 }
 
+void BackendMetal::setPushConstants(const void* memory, size_t size)
+{
+	gContext->push_constants.assign((const uint8_t*)memory, (const uint8_t*)memory + size);
+}
+
+void BackendMetal::setAsyncPipelineCompilation(bool value)
+{
+}
+
+uint32_t BackendMetal::getPendingPipelinesCount()
+{
+	return 0;
+}
+
+MemoryStats BackendMetal::getMemoryStats()
+{
+	return {};
+}
+
+void BackendMetal::setShaderCacheDirectory(const std::string& path)
+{
+}
+
 void BackendMetal::setBlendMode(const std::optional<BlendMode>& blend_mode)
 {
 	if (gContext->pipeline_state.blend_mode == blend_mode)
@@ -1133,6 +1185,10 @@ void BackendMetal::setDepthBias(const std::optional<DepthBias> depth_bias)
 {
 }
 
+void BackendMetal::setStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+}
+
 void BackendMetal::clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
@@ -1259,7 +1315,7 @@ void BackendMetal::writeTexturePixels(TextureHandle* handle, uint32_t width, uin
 	texture->write(width, height, format, memory, mip_level, offset_x, offset_y);
 }
 
-void BackendMetal::generateMips(TextureHandle* handle)
+void BackendMetal::generateMips(TextureHandle* handle, MipmapFilter filter)
 {
 	auto texture = (TextureMetal*)handle;
 	texture->generateMips();
@@ -1369,4 +1425,31 @@ void BackendMetal::writeUniformBufferMemory(UniformBufferHandle* handle, void* m
 	buffer->write(memory, size);
 }
 
+UploadId BackendMetal::writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+	const void* memory, uint32_t mip_level)
+{
+	return 0;
+}
+
+UploadId BackendMetal::writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	return 0;
+}
+
+UploadId BackendMetal::writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	return 0;
+}
+
+bool BackendMetal::isUploadCompleted(UploadId id)
+{
+	return true;
+}
+
+void BackendMetal::waitUpload(UploadId id)
+{
+}
+
 #endif
@@ -6,11 +6,16 @@
 
 #include "shader_compiler.h"
 #include <vulkan/vulkan_raii.hpp>
+#include <vulkan/vulkan_hash.hpp>
 #include <iostream>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <deque>
 
 using namespace skygfx;
 
-class ObjectVK;
 class ShaderVK;
 class RaytracingShaderVK;
 class UniformBufferVK;
@@ -21,6 +26,7 @@ class TextureVK;
 class RenderTargetVK;
 class VertexBufferVK;
 class IndexBufferVK;
+class BufferVK;
 
 struct PipelineStateVK
 {
@@ -65,6 +71,72 @@ SKYGFX_MAKE_HASHABLE(SamplerStateVK,
 	t.texture_address
 );
 
+struct MipmapPipelineStateVK
+{
+	vk::Format format;
+	MipmapFilter filter;
+
+	bool operator==(const MipmapPipelineStateVK& other) const = default;
+};
+
+SKYGFX_MAKE_HASHABLE(MipmapPipelineStateVK,
+	t.format,
+	t.filter
+);
+
+struct PipelineLayoutStateVK
+{
+	vk::PipelineBindPoint pipeline_bind_point = vk::PipelineBindPoint::eGraphics;
+	std::vector<vk::DescriptorSetLayoutBinding> descriptor_bindings;
+	std::optional<vk::PushConstantRange> push_constant_range;
+	bool bindless_textures = false;
+
+	bool operator==(const PipelineLayoutStateVK& other) const = default;
+};
+
+SKYGFX_MAKE_HASHABLE(PipelineLayoutStateVK,
+	t.pipeline_bind_point,
+	t.descriptor_bindings,
+	t.push_constant_range,
+	t.bindless_textures
+);
+
+struct PipelineLayoutVK
+{
+	vk::raii::DescriptorSetLayout descriptor_set_layout = nullptr;
+	vk::raii::PipelineLayout pipeline_layout = nullptr;
+	vk::raii::DescriptorUpdateTemplate descriptor_update_template = nullptr;
+	std::vector<vk::DescriptorSetLayoutBinding> required_descriptor_bindings;
+	std::optional<vk::PushConstantRange> push_constant_range;
+	bool bindless_textures = false;
+};
+
+struct RaytracingShaderBindingTable
+{
+	vk::raii::Buffer buffer = nullptr;
+	vk::raii::DeviceMemory memory = nullptr;
+	vk::StridedDeviceAddressRegionKHR raygen_address;
+	vk::StridedDeviceAddressRegionKHR miss_address;
+	vk::StridedDeviceAddressRegionKHR hit_address;
+	vk::StridedDeviceAddressRegionKHR callable_address;
+};
+
+struct UploadPageVK
+{
+	vk::raii::Buffer buffer = nullptr;
+	vk::raii::DeviceMemory memory = nullptr;
+	uint8_t* memory_ptr = nullptr;
+	vk::DeviceSize size = 0;
+	vk::DeviceSize offset = 0;
+};
+
+union DescriptorDataVK
+{
+	VkDescriptorImageInfo image;
+	VkDescriptorBufferInfo buffer;
+	VkAccelerationStructureKHR acceleration_structure;
+};
+
 using VulkanObject = std::variant<
 	vk::raii::Buffer,
 	vk::raii::Image,
@@ -73,6 +145,123 @@ using VulkanObject = std::variant<
 	vk::raii::AccelerationStructureKHR
 >;
 
+// objects live in dense per-type slots, a handle packs the slot index with the slot generation,
+// the generation changes on every destroy so a stale handle never reaches a reused slot
+
+template <typename T>
+class ObjectPoolVK
+{
+public:
+	template <typename... Args>
+	void* create(Args&&... args)
+	{
+		if (mFreeIndices.empty())
+		{
+			auto index = mSlotCount++;
+			assert(index <= IndexMask);
+
+			if (index / ChunkSize == mChunks.size())
+				mChunks.push_back(std::make_unique<Chunk>());
+
+			mFreeIndices.push_back(index);
+		}
+
+		auto index = mFreeIndices.back();
+		auto& slot = getSlot(index);
+		slot.object.emplace(std::forward<Args>(args)...);
+		mFreeIndices.pop_back();
+
+		return (void*)(((uintptr_t)slot.generation << IndexBits) | index);
+	}
+
+	T* get(const void* handle)
+	{
+		if (handle == nullptr)
+			return nullptr;
+
+		auto& slot = getSlot(handle);
+		return &slot.object.value();
+	}
+
+	// for handles that may outlive their objects, a destroyed or reused slot gives nullptr
+	T* tryGet(const void* handle)
+	{
+		if (handle == nullptr)
+			return nullptr;
+
+		auto index = (uint32_t)((uintptr_t)handle & IndexMask);
+
+		if (index >= mSlotCount)
+			return nullptr;
+
+		auto& slot = getSlot(index);
+
+		if (slot.generation != ((uintptr_t)handle >> IndexBits) || !slot.object.has_value())
+			return nullptr;
+
+		return &slot.object.value();
+	}
+
+	void destroy(const void* handle)
+	{
+		auto& slot = getSlot(handle);
+		slot.object.reset();
+		slot.generation = (slot.generation + 1) & GenerationMask;
+
+		if (slot.generation == 0)
+			slot.generation = 1;
+
+		mFreeIndices.push_back((uint32_t)((uintptr_t)handle & IndexMask));
+	}
+
+	void clear()
+	{
+		for (uint32_t i = 0; i < mSlotCount; i++)
+		{
+			getSlot(i).object.reset();
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::optional<T> object;
+		uintptr_t generation = 1;
+	};
+
+	// chunks never move, so pointers to pooled objects stay valid while the pool grows
+
+	constexpr static uint32_t ChunkSize = 256;
+
+	struct Chunk
+	{
+		std::array<Slot, ChunkSize> slots;
+	};
+
+	constexpr static uint32_t IndexBits = 20;
+	constexpr static uintptr_t IndexMask = (uintptr_t(1) << IndexBits) - 1;
+	constexpr static uintptr_t GenerationMask = std::numeric_limits<uintptr_t>::max() >> IndexBits;
+
+	Slot& getSlot(uint32_t index)
+	{
+		return mChunks[index / ChunkSize]->slots[index % ChunkSize];
+	}
+
+	Slot& getSlot(const void* handle)
+	{
+		auto index = (uint32_t)((uintptr_t)handle & IndexMask);
+		assert(index < mSlotCount);
+		auto& slot = getSlot(index);
+		assert(slot.generation == ((uintptr_t)handle >> IndexBits));
+		assert(slot.object.has_value());
+		return slot;
+	}
+
+	std::vector<std::unique_ptr<Chunk>> mChunks;
+	std::vector<uint32_t> mFreeIndices;
+	uint32_t mSlotCount = 0;
+};
+
 struct ContextVK
 {
 	ContextVK();
@@ -92,44 +281,142 @@ struct ContextVK
 	vk::raii::SwapchainKHR swapchain = nullptr;
 	vk::raii::CommandPool command_pool = nullptr;
 
+	// uploads run on a dedicated transfer queue when the device has one
+
+	struct Upload
+	{
+		UploadId id = 0;
+		uint64_t wait_timeline_value = 0;
+		vk::raii::Fence fence = nullptr;
+		vk::raii::CommandBuffer command_buffer = nullptr;
+		std::vector<VulkanObject> staging_objects;
+		std::vector<vk::ImageMemoryBarrier2> acquire_image_barriers;
+		std::vector<vk::BufferMemoryBarrier2> acquire_buffer_barriers;
+	};
+
+	std::optional<uint32_t> transfer_queue_family_index;
+	vk::raii::Queue transfer_queue = nullptr;
+	vk::raii::CommandPool transfer_command_pool = nullptr;
+	std::vector<Upload> uploads;
+	UploadId last_upload_id = 0;
+	UploadId completed_upload_id = 0;
+	std::vector<vk::ImageMemoryBarrier2> pending_acquire_image_barriers;
+	std::vector<vk::BufferMemoryBarrier2> pending_acquire_buffer_barriers;
+
+	// buffers keep the contents an async write does not cover, so the graphics queue releases them
+	// to the transfer queue at the end of the commands that use them
+
+	std::vector<vk::BufferMemoryBarrier2> pending_release_buffer_barriers;
+
+	// textures are registered into one descriptor array that shaders index by the bindless index
+
+	bool bindless_textures_enabled = false;
+	vk::raii::DescriptorSetLayout bindless_descriptor_set_layout = nullptr;
+	vk::raii::DescriptorPool bindless_descriptor_pool = nullptr;
+	vk::raii::DescriptorSet bindless_descriptor_set = nullptr;
+	vk::raii::Sampler bindless_sampler = nullptr;
+	uint32_t bindless_textures_capacity = 0;
+	uint32_t bindless_textures_count = 0;
+	std::vector<uint32_t> free_bindless_indices;
+	std::unordered_set<TextureVK*> bindless_textures_to_restore;
+	bool bindless_descriptor_set_dirty = true;
+
 	constexpr static vk::Format DefaultDepthStencilFormat = vk::Format::eD32SfloatS8Uint;
 
 	bool working = false;
+	bool vertex_input_dynamic_state_supported = false;
+	bool memory_budget_supported = false;
+	MemoryStats memory_stats;
+	bool raytracing_enabled = false;
+	vk::DeviceSize upload_offset_alignment = 16;
 
 	uint32_t width = 0;
 	uint32_t height = 0;
 
+	constexpr static uint32_t DefaultFramesInFlight = 2;
+
 	struct Frame
 	{
 		vk::raii::Fence fence = nullptr;
-		std::shared_ptr<TextureVK> swapchain_texture;
-		std::shared_ptr<RenderTargetVK> swapchain_target;
 		vk::raii::Semaphore image_acquired_semaphore = nullptr;
-		vk::raii::Semaphore render_complete_semaphore = nullptr;
 		vk::raii::CommandBuffer command_buffer = nullptr;
-		std::vector<VulkanObject> staging_objects;
+		std::vector<UploadPageVK> upload_pages;
+		std::vector<uint32_t> released_bindless_indices;
+	};
+
+	struct Backbuffer
+	{
+		std::shared_ptr<TextureVK> texture;
+		std::shared_ptr<RenderTargetVK> target;
+		vk::raii::Semaphore render_complete_semaphore = nullptr;
 	};
 
 	std::vector<Frame> frames;
 
-	uint32_t semaphore_index = 0;
+	// destroyed objects live until the graphics queue signals the timeline value of the commands that may use them
+
+	vk::raii::Semaphore timeline_semaphore = nullptr;
+	uint64_t submitted_timeline_value = 0;
+	std::deque<std::tuple<uint64_t, VulkanObject>> deletion_queue;
+
+	// destroys from other threads wait here for the next frame, the rendering thread runs them
+	// and queues what they release like its own
+
+	std::thread::id render_thread_id = std::this_thread::get_id();
+	std::mutex pending_destroys_mutex;
+	std::vector<std::function<void()>> pending_destroys;
+	std::vector<Backbuffer> backbuffers;
+
 	uint32_t frame_index = 0;
+	uint32_t image_index = 0;
+	bool image_acquired_semaphore_waited = false;
 
 	Frame& getCurrentFrame() { return frames.at(frame_index); }
+	Backbuffer& getCurrentBackbuffer() { return backbuffers.at(image_index); }
+
+	uint32_t frames_in_flight = DefaultFramesInFlight;
+	vk::PresentModeKHR present_mode = vk::PresentModeKHR::eFifo;
 
 	std::unordered_map<uint32_t, TextureVK*> textures;
 	std::unordered_map<uint32_t, UniformBufferVK*> uniform_buffers;
 	std::unordered_map<uint32_t, StorageBufferVK*> storage_buffers;
 	std::unordered_map<uint32_t, TopLevelAccelerationStructureVK*> top_level_acceleration_structures;
+	std::vector<BottomLevelAccelerationStructureHandle*> pending_bottom_level_acceleration_structures;
+	std::unordered_set<TopLevelAccelerationStructureVK*> all_top_level_acceleration_structures;
+
+	// compacted sizes are read back once the gpu has passed the build, without waiting for it,
+	// the structures are kept by handle since they may be destroyed in the meantime
+
+	struct BlasCompaction
+	{
+		vk::raii::QueryPool query_pool = nullptr;
+		std::vector<BottomLevelAccelerationStructureHandle*> blases;
+		uint64_t timeline_value = 0;
+	};
+
+	std::vector<BlasCompaction> blas_compactions;
+
+	// shaders with the same binding signature share one layout
+	std::unordered_map<PipelineLayoutStateVK, PipelineLayoutVK> pipeline_layouts;
 
 	std::unordered_map<PipelineStateVK, vk::raii::Pipeline> pipeline_states;
 
 	RaytracingPipelineStateVK raytracing_pipeline_state;
 	std::unordered_map<RaytracingPipelineStateVK, vk::raii::Pipeline> raytracing_pipeline_states;
+	std::unordered_map<RaytracingPipelineStateVK, RaytracingShaderBindingTable> raytracing_shader_binding_tables;
+
+	// pipelines compiled on worker threads, draws that need them are skipped until they are ready
+	bool async_pipeline_compilation = false;
+	std::unordered_map<PipelineStateVK, std::future<vk::raii::Pipeline>> pending_pipeline_states;
+	std::unordered_map<RaytracingPipelineStateVK, std::future<vk::raii::Pipeline>> pending_raytracing_pipeline_states;
 
 	SamplerStateVK sampler_state;
 	std::unordered_map<SamplerStateVK, vk::raii::Sampler> sampler_states;
 
+	vk::raii::DescriptorSetLayout mipmap_descriptor_set_layout = nullptr;
+	vk::raii::PipelineLayout mipmap_pipeline_layout = nullptr;
+	std::unordered_map<MipmapPipelineStateVK, vk::raii::Pipeline> mipmap_pipeline_states;
+
 	std::vector<RenderTargetVK*> render_targets;
 
 	PipelineStateVK pipeline_state;
@@ -141,6 +428,8 @@ struct ContextVK
 	FrontFace front_face = FrontFace::Clockwise;
 	Topology topology = Topology::TriangleList;
 	std::vector<VertexBufferVK*> vertex_buffers; // TODO: store pointer and count, not std::vector
+	std::vector<InputLayout> input_layouts;
+	std::vector<uint32_t> input_layout_strides; // last set with the vertex input
 	IndexBufferVK* index_buffer = nullptr;
 	std::optional<BlendMode> blend_mode;
 
@@ -153,10 +442,17 @@ struct ContextVK
 	bool front_face_dirty = true;
 	bool topology_dirty = true;
 	bool vertex_buffers_dirty = true;
+	bool input_layouts_dirty = true;
 	bool index_buffer_dirty = true;
 	bool blend_mode_dirty = true;
 
-	std::unordered_set<uint32_t> graphics_pipeline_ignore_bindings;
+	std::unordered_set<uint32_t> dirty_descriptor_bindings;
+	bool graphics_descriptors_dirty = true;
+	vk::PipelineLayout graphics_pipeline_layout = nullptr;
+	std::vector<DescriptorDataVK> descriptor_data;
+
+	std::vector<uint8_t> push_constants;
+	bool push_constants_dirty = true;
 
 	uint32_t getBackbufferWidth();
 	uint32_t getBackbufferHeight();
@@ -164,9 +460,31 @@ struct ContextVK
 
 	bool render_pass_active = false;
 
+	std::optional<glm::vec4> clear_color;
+	std::optional<float> clear_depth;
+	std::optional<uint8_t> clear_stencil;
+
+	// requested for the next explicit end of the targets usage, implicit pass splits always store
+	vk::AttachmentStoreOp color_store_op = vk::AttachmentStoreOp::eStore;
+	vk::AttachmentStoreOp depth_stencil_store_op = vk::AttachmentStoreOp::eStore;
+
 	vk::PipelineStageFlags2 current_memory_stage = vk::PipelineStageFlagBits2::eTransfer;
 
-	std::unordered_set<ObjectVK*> objects;
+	std::vector<BufferVK*> buffers_with_frame_uploads;
+
+	std::vector<vk::ImageMemoryBarrier2> pending_image_barriers;
+	std::optional<vk::MemoryBarrier2> pending_memory_barrier;
+
+	ObjectPoolVK<ShaderVK> shader_pool;
+	ObjectPoolVK<RaytracingShaderVK> raytracing_shader_pool;
+	ObjectPoolVK<TextureVK> texture_pool;
+	ObjectPoolVK<RenderTargetVK> render_target_pool;
+	ObjectPoolVK<VertexBufferVK> vertex_buffer_pool;
+	ObjectPoolVK<IndexBufferVK> index_buffer_pool;
+	ObjectPoolVK<UniformBufferVK> uniform_buffer_pool;
+	ObjectPoolVK<StorageBufferVK> storage_buffer_pool;
+	ObjectPoolVK<BottomLevelAccelerationStructureVK> bottom_level_acceleration_structure_pool;
+	ObjectPoolVK<TopLevelAccelerationStructureVK> top_level_acceleration_structure_pool;
 };
 
 static ContextVK* gContext = nullptr;
@@ -182,6 +500,53 @@ static uint32_t GetMemoryType(vk::MemoryPropertyFlags properties, uint32_t type_
 	return 0xFFFFFFFF; // Unable to find memoryType
 }
 
+static void AddMemoryUsage(MemoryStats::Category& category, vk::DeviceSize size)
+{
+	category.size += size;
+	category.peak_size = std::max(category.peak_size, category.size);
+}
+
+static void RemoveMemoryUsage(MemoryStats::Category& category, vk::DeviceSize size)
+{
+	assert(category.size >= size);
+	category.size -= size;
+}
+
+static MemoryStats GetMemoryStats()
+{
+	auto stats = gContext->memory_stats;
+
+	auto add_heaps = [&](const vk::PhysicalDeviceMemoryProperties& memory_properties,
+		const vk::PhysicalDeviceMemoryBudgetPropertiesEXT* budget_properties) {
+		for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+		{
+			const auto& heap = memory_properties.memoryHeaps[i];
+
+			MemoryStats::Heap heap_stats;
+			heap_stats.device_local = (bool)(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+			heap_stats.budget = budget_properties ? budget_properties->heapBudget[i] : heap.size;
+			heap_stats.usage = budget_properties ? budget_properties->heapUsage[i] : 0;
+
+			stats.heaps.push_back(heap_stats);
+		}
+	};
+
+	if (gContext->memory_budget_supported)
+	{
+		auto properties = gContext->physical_device.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+			vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+		add_heaps(properties.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties,
+			&properties.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>());
+	}
+	else
+	{
+		add_heaps(gContext->physical_device.getMemoryProperties(), nullptr);
+	}
+
+	return stats;
+}
+
 static std::tuple<vk::raii::Buffer, vk::raii::DeviceMemory> CreateBuffer(uint64_t size, vk::BufferUsageFlags usage)
 {
 	auto buffer_create_info = vk::BufferCreateInfo()
@@ -205,10 +570,12 @@ static std::tuple<vk::raii::Buffer, vk::raii::DeviceMemory> CreateBuffer(uint64_
 	return { std::move(buffer), std::move(device_memory) };
 }
 
-static vk::raii::ImageView CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspect_flags, uint32_t mip_levels = 1)
+static vk::raii::ImageView CreateImageView(vk::Image image, vk::Format format, vk::ImageAspectFlags aspect_flags,
+	uint32_t mip_levels = 1, uint32_t base_mip_level = 0)
 {
 	auto image_subresource_range = vk::ImageSubresourceRange()
 		.setAspectMask(aspect_flags)
+		.setBaseMipLevel(base_mip_level)
 		.setLevelCount(mip_levels)
 		.setLayerCount(1);
 
@@ -269,165 +636,618 @@ static void WriteToBuffer(vk::raii::DeviceMemory& memory, const void* data, size
 	memory.unmapMemory();
 };
 
+template<typename T>
+inline T AlignUp(T size, size_t alignment) noexcept
+{
+	if (alignment > 0)
+	{
+		assert(((alignment - 1) & alignment) == 0);
+		auto mask = static_cast<T>(alignment - 1);
+		return (size + mask) & ~mask;
+	}
+	return size;
+}
+
 static void DestroyStaging(VulkanObject&& object)
 {
-	gContext->getCurrentFrame().staging_objects.push_back(std::move(object));
+	// the commands being recorded now will signal the next timeline value
+
+	gContext->deletion_queue.push_back({ gContext->submitted_timeline_value + 1, std::move(object) });
 }
 
-static void ReleaseStaging()
+static void ReleaseDestroyedObjects()
 {
-	gContext->getCurrentFrame().staging_objects.clear();
+	auto completed_value = gContext->timeline_semaphore.getCounterValue();
+
+	while (!gContext->deletion_queue.empty() && std::get<0>(gContext->deletion_queue.front()) <= completed_value)
+	{
+		gContext->deletion_queue.pop_front();
+	}
 }
 
-static void BeginRenderPass();
-static void EndRenderPass();
-static void EnsureRenderPassActivated();
-static void EnsureRenderPassDeactivated();
-static void SetImageMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Image image, vk::ImageAspectFlags aspect_mask,
-	vk::ImageLayout old_layout, vk::ImageLayout new_layout, uint32_t base_mip_level = 0,
-	uint32_t level_count = VK_REMAINING_MIP_LEVELS, uint32_t base_array_layer = 0,
-	uint32_t layer_count = VK_REMAINING_ARRAY_LAYERS);
+static bool DeferDestroyToRenderThread(std::function<void()> destroy)
+{
+	if (std::this_thread::get_id() == gContext->render_thread_id)
+		return false;
 
-static void SetImageMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Image image, vk::Format format,
-	vk::ImageLayout old_layout, vk::ImageLayout new_layout, uint32_t base_mip_level = 0,
-	uint32_t level_count = VK_REMAINING_MIP_LEVELS, uint32_t base_array_layer = 0,
-	uint32_t layer_count = VK_REMAINING_ARRAY_LAYERS);
+	std::scoped_lock lock(gContext->pending_destroys_mutex);
+	gContext->pending_destroys.push_back(std::move(destroy));
+	return true;
+}
 
-static void EnsureMemoryState(const vk::raii::CommandBuffer& cmdbuf, vk::PipelineStageFlags2 stage);
-static void OneTimeSubmit(std::function<void(const vk::raii::CommandBuffer&)> func);
+static void RunPendingDestroys()
+{
+	std::vector<std::function<void()>> destroys;
 
-static const std::unordered_map<VertexFormat, vk::Format> VertexFormatMap = {
-	{ VertexFormat::Float1, vk::Format::eR32Sfloat },
-	{ VertexFormat::Float2, vk::Format::eR32G32Sfloat },
-	{ VertexFormat::Float3, vk::Format::eR32G32B32Sfloat },
-	{ VertexFormat::Float4, vk::Format::eR32G32B32A32Sfloat },
-	{ VertexFormat::UChar1Normalized, vk::Format::eR8Unorm },
-	{ VertexFormat::UChar2Normalized, vk::Format::eR8G8Unorm },
-	{ VertexFormat::UChar4Normalized, vk::Format::eR8G8B8A8Unorm },
-	{ VertexFormat::UChar1, vk::Format::eR8Uint },
-	{ VertexFormat::UChar2, vk::Format::eR8G8Uint },
-	{ VertexFormat::UChar4, vk::Format::eR8G8B8A8Uint }
-};
+	{
+		std::scoped_lock lock(gContext->pending_destroys_mutex);
+		destroys = std::exchange(gContext->pending_destroys, {});
+	}
 
-static const std::unordered_map<PixelFormat, vk::Format> PixelFormatMap = {
-	{ PixelFormat::R32Float, vk::Format::eR32Sfloat },
-	{ PixelFormat::RG32Float, vk::Format::eR32G32Sfloat },
-	{ PixelFormat::RGB32Float, vk::Format::eR32G32B32Sfloat },
-	{ PixelFormat::RGBA32Float, vk::Format::eR32G32B32A32Sfloat },
-	{ PixelFormat::R8UNorm, vk::Format::eR8Unorm },
-	{ PixelFormat::RG8UNorm, vk::Format::eR8G8Unorm },
-	{ PixelFormat::RGBA8UNorm, vk::Format::eR8G8B8A8Unorm },
-};
+	// the objects are released with the commands being recorded now, as if destroyed at this point
+	for (const auto& destroy : destroys)
+	{
+		destroy();
+	}
+}
 
-static const std::unordered_map<vk::Format, PixelFormat> ReversedPixelFormatMap = {
-	{ vk::Format::eR32Sfloat, PixelFormat::R32Float },
-	{ vk::Format::eR32G32Sfloat, PixelFormat::RG32Float },
-	{ vk::Format::eR32G32B32Sfloat, PixelFormat::RGB32Float },
-	{ vk::Format::eR32G32B32A32Sfloat, PixelFormat::RGBA32Float },
-	{ vk::Format::eR8Unorm, PixelFormat::R8UNorm },
-	{ vk::Format::eR8G8Unorm, PixelFormat::RG8UNorm },
-	{ vk::Format::eR8G8B8A8Unorm, PixelFormat::RGBA8UNorm }
-};
+static void ReleaseStaging()
+{
+	auto& frame = gContext->getCurrentFrame();
 
-const static std::unordered_map<ComparisonFunc, vk::CompareOp> CompareOpMap = {
-	{ ComparisonFunc::Always, vk::CompareOp::eAlways },
-	{ ComparisonFunc::Never, vk::CompareOp::eNever },
-	{ ComparisonFunc::Less, vk::CompareOp::eLess },
-	{ ComparisonFunc::Equal, vk::CompareOp::eEqual },
-	{ ComparisonFunc::NotEqual, vk::CompareOp::eNotEqual },
-	{ ComparisonFunc::LessEqual, vk::CompareOp::eLessOrEqual },
-	{ ComparisonFunc::Greater, vk::CompareOp::eGreater },
-	{ ComparisonFunc::GreaterEqual, vk::CompareOp::eGreaterOrEqual }
-};
+	ReleaseDestroyedObjects();
 
-const static std::unordered_map<ShaderStage, vk::ShaderStageFlagBits> ShaderStageMap = {
-	{ ShaderStage::Vertex, vk::ShaderStageFlagBits::eVertex },
-	{ ShaderStage::Fragment, vk::ShaderStageFlagBits::eFragment },
-	{ ShaderStage::Raygen, vk::ShaderStageFlagBits::eRaygenKHR },
-	{ ShaderStage::Miss, vk::ShaderStageFlagBits::eMissKHR },
-	{ ShaderStage::ClosestHit, vk::ShaderStageFlagBits::eClosestHitKHR }
-};
+	for (auto& page : frame.upload_pages)
+	{
+		page.offset = 0;
+	}
 
-const static std::unordered_map<ShaderReflection::DescriptorType, vk::DescriptorType> ShaderTypeMap = {
-	{ ShaderReflection::DescriptorType::CombinedImageSampler, vk::DescriptorType::eCombinedImageSampler },
-	{ ShaderReflection::DescriptorType::UniformBuffer, vk::DescriptorType::eUniformBuffer },
-	{ ShaderReflection::DescriptorType::StorageImage, vk::DescriptorType::eStorageImage },
-	{ ShaderReflection::DescriptorType::AccelerationStructure, vk::DescriptorType::eAccelerationStructureKHR },
-	{ ShaderReflection::DescriptorType::StorageBuffer, vk::DescriptorType::eStorageBuffer }
-};
+	gContext->free_bindless_indices.insert(gContext->free_bindless_indices.end(),
+		frame.released_bindless_indices.begin(), frame.released_bindless_indices.end());
+	frame.released_bindless_indices.clear();
+}
 
-std::tuple<vk::raii::PipelineLayout, vk::raii::DescriptorSetLayout, std::vector<vk::DescriptorSetLayoutBinding>> CreatePipelineLayout(
-	const std::vector<std::vector<uint32_t>>& spirvs)
+static uint32_t AddBindlessTexture(vk::ImageView image_view)
 {
-	std::vector<vk::DescriptorSetLayoutBinding> required_descriptor_bindings;
+	assert(gContext->bindless_textures_enabled);
 
-	for (const auto& spirv : spirvs)
+	uint32_t index;
+
+	if (!gContext->free_bindless_indices.empty())
 	{
-		auto reflection = MakeSpirvReflection(spirv);
+		index = gContext->free_bindless_indices.back();
+		gContext->free_bindless_indices.pop_back();
+	}
+	else
+	{
+		if (gContext->bindless_textures_count >= gContext->bindless_textures_capacity)
+			throw std::runtime_error("too many bindless textures");
 
-		for (const auto& [type, descriptor_bindings] : reflection.typed_descriptor_bindings)
-		{
-			for (const auto& [binding, descriptor] : descriptor_bindings)
-			{
-				bool overwritten = false;
+		index = gContext->bindless_textures_count++;
+	}
 
-				for (auto& _binding : required_descriptor_bindings)
-				{
-					if (_binding.binding != binding)
-						continue;
+	auto image_info = vk::DescriptorImageInfo()
+		.setSampler(*gContext->bindless_sampler)
+		.setImageView(image_view)
+		.setImageLayout(vk::ImageLayout::eGeneral);
 
-					_binding.stageFlags |= ShaderStageMap.at(reflection.stage);
-					overwritten = true;
-					break;
-				}
+	auto write = vk::WriteDescriptorSet()
+		.setDstSet(*gContext->bindless_descriptor_set)
+		.setDstBinding(0)
+		.setDstArrayElement(index)
+		.setDescriptorCount(1)
+		.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+		.setPImageInfo(&image_info);
 
-				if (overwritten)
-					continue;
+	gContext->device.updateDescriptorSets({ write }, {});
 
-				auto descriptor_set_layout_binding = vk::DescriptorSetLayoutBinding()
-					.setDescriptorType(ShaderTypeMap.at(type))
-					.setDescriptorCount(1)
-					.setBinding(binding)
+	return index;
+}
+
+static void RemoveBindlessTexture(uint32_t index)
+{
+	// the slot can be taken by another texture only when frames that may still read it are finished
+	gContext->getCurrentFrame().released_bindless_indices.push_back(index);
+}
+
+static std::tuple<vk::Buffer, vk::DeviceSize> WriteToFrameUploadMemory(const void* memory, size_t size)
+{
+	// linear allocator over persistently mapped pages, rewound when the frame is reused
+
+	constexpr vk::DeviceSize PageSize = 4 * 1024 * 1024;
+
+	auto& pages = gContext->getCurrentFrame().upload_pages;
+	auto alignment = gContext->upload_offset_alignment;
+
+	auto page = std::find_if(pages.begin(), pages.end(), [&](const UploadPageVK& candidate) {
+		return AlignUp(candidate.offset, alignment) + size <= candidate.size;
+	});
+
+	if (page == pages.end())
+	{
+		auto page_size = std::max<vk::DeviceSize>(PageSize, size);
+
+		auto usage =
+			vk::BufferUsageFlagBits::eVertexBuffer |
+			vk::BufferUsageFlagBits::eIndexBuffer |
+			vk::BufferUsageFlagBits::eUniformBuffer |
+			vk::BufferUsageFlagBits::eStorageBuffer |
+			vk::BufferUsageFlagBits::eTransferSrc;
+
+		auto new_page = UploadPageVK();
+		std::tie(new_page.buffer, new_page.memory) = CreateBuffer(page_size, usage);
+		new_page.memory_ptr = (uint8_t*)new_page.memory.mapMemory(0, page_size);
+		new_page.size = page_size;
+
+		pages.push_back(std::move(new_page));
+		page = std::prev(pages.end());
+	}
+
+	auto offset = AlignUp(page->offset, alignment);
+	memcpy(page->memory_ptr + offset, memory, size);
+	page->offset = offset + size;
+
+	return { *page->buffer, offset };
+}
+
+static void BeginRenderPass();
+static void EndRenderPass();
+static void EnsureRenderPassActivated();
+static void EnsureRenderPassDeactivated();
+static void AddImageMemoryBarrier(vk::Image image, vk::ImageAspectFlags aspect_mask, vk::ImageLayout old_layout,
+	vk::ImageLayout new_layout, uint32_t base_mip_level, uint32_t level_count);
+static void SetMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::PipelineStageFlags2 src_stage,
+	vk::PipelineStageFlags2 dst_stage);
+static void EnsureMemoryState(vk::PipelineStageFlags2 stage);
+static bool HasPendingBarriers();
+static void FlushBarriers(const vk::raii::CommandBuffer& cmdbuf);
+static void BuildAccelerationStructures(const std::vector<vk::AccelerationStructureBuildGeometryInfoKHR>& build_geometry_infos,
+	const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& build_range_infos);
+static void BuildPendingBottomLevelAccelerationStructures();
+static void FlushCommandBuffer();
+
+static ContextVK::Upload& BeginUpload()
+{
+	auto command_buffer_allocate_info = vk::CommandBufferAllocateInfo()
+		.setCommandBufferCount(1)
+		.setLevel(vk::CommandBufferLevel::ePrimary)
+		.setCommandPool(*gContext->transfer_command_pool);
+
+	auto upload = ContextVK::Upload();
+	upload.id = ++gContext->last_upload_id;
+
+	// the transfer must not overwrite resources that the recorded commands of this frame still use
+	upload.wait_timeline_value = gContext->working ? gContext->submitted_timeline_value + 1 :
+		gContext->submitted_timeline_value;
+	upload.fence = gContext->device.createFence({});
+	upload.command_buffer = std::move(gContext->device.allocateCommandBuffers(command_buffer_allocate_info).at(0));
+
+	auto begin_info = vk::CommandBufferBeginInfo()
+		.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+	upload.command_buffer.begin(begin_info);
+
+	return gContext->uploads.emplace_back(std::move(upload));
+}
+
+static void EndUpload(ContextVK::Upload& upload)
+{
+	upload.command_buffer.end();
+
+	auto wait_dst_stage_mask = vk::PipelineStageFlags{
+		vk::PipelineStageFlagBits::eAllCommands
+	};
+
+	// timeline semaphores allow to wait for a value whose signal is submitted later with the frame
+
+	auto timeline_submit_info = vk::TimelineSemaphoreSubmitInfo()
+		.setWaitSemaphoreValues(upload.wait_timeline_value);
+
+	auto submit_info = vk::SubmitInfo()
+		.setCommandBuffers(*upload.command_buffer)
+		.setWaitSemaphores(*gContext->timeline_semaphore)
+		.setWaitDstStageMask(wait_dst_stage_mask)
+		.setPNext(&timeline_submit_info);
+
+	gContext->transfer_queue.submit(submit_info, *upload.fence);
+}
+
+static void FlushAcquireBarriers()
+{
+	if (gContext->pending_acquire_image_barriers.empty() && gContext->pending_acquire_buffer_barriers.empty())
+		return;
+
+	EnsureRenderPassDeactivated();
+
+	auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+	FlushBarriers(cmdbuf);
+
+	auto dependency_info = vk::DependencyInfo()
+		.setImageMemoryBarriers(gContext->pending_acquire_image_barriers)
+		.setBufferMemoryBarriers(gContext->pending_acquire_buffer_barriers);
+
+	cmdbuf.pipelineBarrier2(dependency_info);
+
+	gContext->pending_acquire_image_barriers.clear();
+	gContext->pending_acquire_buffer_barriers.clear();
+}
+
+static void FlushReleaseBarriers()
+{
+	if (gContext->pending_release_buffer_barriers.empty())
+		return;
+
+	assert(!gContext->render_pass_active);
+
+	auto dependency_info = vk::DependencyInfo()
+		.setBufferMemoryBarriers(gContext->pending_release_buffer_barriers);
+
+	gContext->getCurrentFrame().command_buffer.pipelineBarrier2(dependency_info);
+
+	gContext->pending_release_buffer_barriers.clear();
+}
+
+static void CompleteUpload(ContextVK::Upload& upload)
+{
+	// the graphics queue takes ownership of the uploaded resources, outside of a frame
+	// the barriers wait for the command buffer of the next one
+
+	std::ranges::move(upload.acquire_image_barriers, std::back_inserter(gContext->pending_acquire_image_barriers));
+	std::ranges::move(upload.acquire_buffer_barriers, std::back_inserter(gContext->pending_acquire_buffer_barriers));
+
+	if (gContext->working)
+		FlushAcquireBarriers();
+
+	gContext->completed_upload_id = upload.id;
+}
+
+static void PollUploads()
+{
+	auto& uploads = gContext->uploads;
+
+	auto it = uploads.begin();
+
+	while (it != uploads.end() && it->fence.getStatus() == vk::Result::eSuccess)
+	{
+		CompleteUpload(*it);
+		++it;
+	}
+
+	uploads.erase(uploads.begin(), it);
+}
+
+static void WaitUpload(UploadId id)
+{
+	if (id <= gContext->completed_upload_id)
+		return;
+
+	// an upload that waits for the commands of this frame can only complete once they are submitted
+
+	auto waits_for_frame = std::ranges::any_of(gContext->uploads, [&](const ContextVK::Upload& upload) {
+		return upload.id <= id && upload.wait_timeline_value > gContext->submitted_timeline_value;
+	});
+
+	if (waits_for_frame)
+		FlushCommandBuffer();
+
+	if (id <= gContext->completed_upload_id)
+		return;
+
+	// fences of one queue signal in submission order, so everything before the upload is completed as well
+
+	auto& uploads = gContext->uploads;
+
+	auto it = uploads.begin();
+
+	while (it != uploads.end() && it->id <= id)
+	{
+		auto wait_result = gContext->device.waitForFences({ *it->fence }, true, UINT64_MAX);
+		CompleteUpload(*it);
+		++it;
+	}
+
+	uploads.erase(uploads.begin(), it);
+}
+
+static const std::unordered_map<VertexFormat, vk::Format> VertexFormatMap = {
+	{ VertexFormat::Float1, vk::Format::eR32Sfloat },
+	{ VertexFormat::Float2, vk::Format::eR32G32Sfloat },
+	{ VertexFormat::Float3, vk::Format::eR32G32B32Sfloat },
+	{ VertexFormat::Float4, vk::Format::eR32G32B32A32Sfloat },
+	{ VertexFormat::UChar1Normalized, vk::Format::eR8Unorm },
+	{ VertexFormat::UChar2Normalized, vk::Format::eR8G8Unorm },
+	{ VertexFormat::UChar4Normalized, vk::Format::eR8G8B8A8Unorm },
+	{ VertexFormat::UChar1, vk::Format::eR8Uint },
+	{ VertexFormat::UChar2, vk::Format::eR8G8Uint },
+	{ VertexFormat::UChar4, vk::Format::eR8G8B8A8Uint }
+};
+
+static const std::unordered_map<PixelFormat, vk::Format> PixelFormatMap = {
+	{ PixelFormat::R32Float, vk::Format::eR32Sfloat },
+	{ PixelFormat::RG32Float, vk::Format::eR32G32Sfloat },
+	{ PixelFormat::RGB32Float, vk::Format::eR32G32B32Sfloat },
+	{ PixelFormat::RGBA32Float, vk::Format::eR32G32B32A32Sfloat },
+	{ PixelFormat::R8UNorm, vk::Format::eR8Unorm },
+	{ PixelFormat::RG8UNorm, vk::Format::eR8G8Unorm },
+	{ PixelFormat::RGBA8UNorm, vk::Format::eR8G8B8A8Unorm },
+};
+
+static const std::unordered_map<vk::Format, PixelFormat> ReversedPixelFormatMap = {
+	{ vk::Format::eR32Sfloat, PixelFormat::R32Float },
+	{ vk::Format::eR32G32Sfloat, PixelFormat::RG32Float },
+	{ vk::Format::eR32G32B32Sfloat, PixelFormat::RGB32Float },
+	{ vk::Format::eR32G32B32A32Sfloat, PixelFormat::RGBA32Float },
+	{ vk::Format::eR8Unorm, PixelFormat::R8UNorm },
+	{ vk::Format::eR8G8Unorm, PixelFormat::RG8UNorm },
+	{ vk::Format::eR8G8B8A8Unorm, PixelFormat::RGBA8UNorm }
+};
+
+const static std::unordered_map<ComparisonFunc, vk::CompareOp> CompareOpMap = {
+	{ ComparisonFunc::Always, vk::CompareOp::eAlways },
+	{ ComparisonFunc::Never, vk::CompareOp::eNever },
+	{ ComparisonFunc::Less, vk::CompareOp::eLess },
+	{ ComparisonFunc::Equal, vk::CompareOp::eEqual },
+	{ ComparisonFunc::NotEqual, vk::CompareOp::eNotEqual },
+	{ ComparisonFunc::LessEqual, vk::CompareOp::eLessOrEqual },
+	{ ComparisonFunc::Greater, vk::CompareOp::eGreater },
+	{ ComparisonFunc::GreaterEqual, vk::CompareOp::eGreaterOrEqual }
+};
+
+const static std::unordered_map<ShaderStage, vk::ShaderStageFlagBits> ShaderStageMap = {
+	{ ShaderStage::Vertex, vk::ShaderStageFlagBits::eVertex },
+	{ ShaderStage::Fragment, vk::ShaderStageFlagBits::eFragment },
+	{ ShaderStage::Raygen, vk::ShaderStageFlagBits::eRaygenKHR },
+	{ ShaderStage::Miss, vk::ShaderStageFlagBits::eMissKHR },
+	{ ShaderStage::ClosestHit, vk::ShaderStageFlagBits::eClosestHitKHR },
+	{ ShaderStage::Compute, vk::ShaderStageFlagBits::eCompute }
+};
+
+const static std::unordered_map<ShaderReflection::DescriptorType, vk::DescriptorType> ShaderTypeMap = {
+	{ ShaderReflection::DescriptorType::CombinedImageSampler, vk::DescriptorType::eCombinedImageSampler },
+	{ ShaderReflection::DescriptorType::UniformBuffer, vk::DescriptorType::eUniformBuffer },
+	{ ShaderReflection::DescriptorType::StorageImage, vk::DescriptorType::eStorageImage },
+	{ ShaderReflection::DescriptorType::AccelerationStructure, vk::DescriptorType::eAccelerationStructureKHR },
+	{ ShaderReflection::DescriptorType::StorageBuffer, vk::DescriptorType::eStorageBuffer }
+};
+
+static PipelineLayoutStateVK MakePipelineLayoutState(vk::PipelineBindPoint pipeline_bind_point,
+	const std::vector<std::vector<uint32_t>>& spirvs)
+{
+	PipelineLayoutStateVK state;
+	state.pipeline_bind_point = pipeline_bind_point;
+
+	auto& required_descriptor_bindings = state.descriptor_bindings;
+	auto& push_constant_range = state.push_constant_range;
+
+	for (const auto& spirv : spirvs)
+	{
+		auto reflection = MakeSpirvReflection(spirv);
+
+		if (reflection.bindless_textures)
+			state.bindless_textures = true;
+
+		if (reflection.push_constants.has_value())
+		{
+			// all stages share a single range, so every stage can read the whole block
+
+			if (!push_constant_range.has_value())
+				push_constant_range = vk::PushConstantRange();
+
+			auto& range = push_constant_range.value();
+			range.stageFlags |= ShaderStageMap.at(reflection.stage);
+			range.size = std::max(range.size, reflection.push_constants->size);
+		}
+
+		for (const auto& [type, descriptor_bindings] : reflection.typed_descriptor_bindings)
+		{
+			for (const auto& [binding, descriptor] : descriptor_bindings)
+			{
+				bool overwritten = false;
+
+				for (auto& _binding : required_descriptor_bindings)
+				{
+					if (_binding.binding != binding)
+						continue;
+
+					_binding.stageFlags |= ShaderStageMap.at(reflection.stage);
+					overwritten = true;
+					break;
+				}
+
+				if (overwritten)
+					continue;
+
+				auto descriptor_set_layout_binding = vk::DescriptorSetLayoutBinding()
+					.setDescriptorType(ShaderTypeMap.at(type))
+					.setDescriptorCount(1)
+					.setBinding(binding)
 					.setStageFlags(ShaderStageMap.at(reflection.stage));
 
 				required_descriptor_bindings.push_back(descriptor_set_layout_binding);
 			}
 		}
 	}
+
+	// sorted bindings make the state independent of the stage and declaration order
+
+	std::ranges::sort(required_descriptor_bindings, {}, &vk::DescriptorSetLayoutBinding::binding);
+
+	return state;
+}
+
+static vk::raii::DescriptorUpdateTemplate CreateDescriptorUpdateTemplate(vk::PipelineBindPoint pipeline_bind_point,
+	const vk::raii::PipelineLayout& pipeline_layout, const vk::raii::DescriptorSetLayout& descriptor_set_layout,
+	const std::vector<vk::DescriptorSetLayoutBinding>& required_descriptor_bindings)
+{
+	if (required_descriptor_bindings.empty())
+		return nullptr;
+
+	std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+
+	for (size_t i = 0; i < required_descriptor_bindings.size(); i++)
+	{
+		const auto& required_descriptor_binding = required_descriptor_bindings.at(i);
+
+		auto entry = vk::DescriptorUpdateTemplateEntry()
+			.setDstBinding(required_descriptor_binding.binding)
+			.setDescriptorCount(1)
+			.setDescriptorType(required_descriptor_binding.descriptorType)
+			.setOffset(i * sizeof(DescriptorDataVK))
+			.setStride(sizeof(DescriptorDataVK));
+
+		entries.push_back(entry);
+	}
+
+	auto descriptor_update_template_create_info = vk::DescriptorUpdateTemplateCreateInfo()
+		.setDescriptorUpdateEntries(entries)
+		.setTemplateType(vk::DescriptorUpdateTemplateType::ePushDescriptorsKHR)
+		.setDescriptorSetLayout(*descriptor_set_layout)
+		.setPipelineBindPoint(pipeline_bind_point)
+		.setPipelineLayout(*pipeline_layout)
+		.setSet(0);
+
+	return gContext->device.createDescriptorUpdateTemplate(descriptor_update_template_create_info);
+}
+
+static const PipelineLayoutVK& GetPipelineLayout(vk::PipelineBindPoint pipeline_bind_point,
+	const std::vector<std::vector<uint32_t>>& spirvs)
+{
+	auto state = MakePipelineLayoutState(pipeline_bind_point, spirvs);
+
+	if (auto it = gContext->pipeline_layouts.find(state); it != gContext->pipeline_layouts.end())
+		return it->second;
+
+	PipelineLayoutVK pipeline_layout;
+	pipeline_layout.required_descriptor_bindings = state.descriptor_bindings;
+	pipeline_layout.push_constant_range = state.push_constant_range;
+	pipeline_layout.bindless_textures = state.bindless_textures;
+
 	auto descriptor_set_layout_create_info = vk::DescriptorSetLayoutCreateInfo()
 		.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
-		.setBindings(required_descriptor_bindings);
+		.setBindings(state.descriptor_bindings);
 
-	auto descriptor_set_layout = gContext->device.createDescriptorSetLayout(descriptor_set_layout_create_info);
+	pipeline_layout.descriptor_set_layout = gContext->device.createDescriptorSetLayout(descriptor_set_layout_create_info);
+
+	std::vector<vk::DescriptorSetLayout> set_layouts = { *pipeline_layout.descriptor_set_layout };
+
+	if (state.bindless_textures)
+	{
+		if (!gContext->bindless_textures_enabled)
+			throw std::runtime_error("shader uses bindless textures, but they are not enabled");
+
+		assert(set_layouts.size() == BindlessTexturesSet);
+		set_layouts.push_back(*gContext->bindless_descriptor_set_layout);
+	}
 
 	auto pipeline_layout_create_info = vk::PipelineLayoutCreateInfo()
-		.setSetLayouts(*descriptor_set_layout);
+		.setSetLayouts(set_layouts);
+
+	if (state.push_constant_range.has_value())
+		pipeline_layout_create_info.setPushConstantRanges(state.push_constant_range.value());
 
-	auto pipeline_layout = gContext->device.createPipelineLayout(pipeline_layout_create_info);
+	pipeline_layout.pipeline_layout = gContext->device.createPipelineLayout(pipeline_layout_create_info);
 
-	return { std::move(pipeline_layout), std::move(descriptor_set_layout), required_descriptor_bindings };
+	pipeline_layout.descriptor_update_template = CreateDescriptorUpdateTemplate(pipeline_bind_point,
+		pipeline_layout.pipeline_layout, pipeline_layout.descriptor_set_layout, state.descriptor_bindings);
+
+	return gContext->pipeline_layouts.emplace(std::move(state), std::move(pipeline_layout)).first->second;
 }
 
-class ObjectVK
+static bool IsMipmapComputeSupported(vk::Format format, MipmapFilter filter)
 {
-public:
-	virtual ~ObjectVK() {}
-};
+	if (!ReversedPixelFormatMap.contains(format))
+		return false;
+
+	if (!GetMipmapComputeShaderDefines(ReversedPixelFormatMap.at(format), filter).has_value())
+		return false;
+
+	auto format_properties = gContext->physical_device.getFormatProperties(format);
+
+	return (bool)(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage);
+}
+
+static const vk::raii::Pipeline& GetMipmapPipeline(vk::Format format, MipmapFilter filter)
+{
+	if (!*gContext->mipmap_pipeline_layout)
+	{
+		std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+		for (uint32_t i = 0; i <= MipmapComputeMaxMipsPerPass; i++)
+		{
+			auto binding = vk::DescriptorSetLayoutBinding()
+				.setDescriptorType(vk::DescriptorType::eStorageImage)
+				.setDescriptorCount(1)
+				.setBinding(i)
+				.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+			bindings.push_back(binding);
+		}
+
+		auto descriptor_set_layout_create_info = vk::DescriptorSetLayoutCreateInfo()
+			.setFlags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
+			.setBindings(bindings);
+
+		gContext->mipmap_descriptor_set_layout = gContext->device.createDescriptorSetLayout(descriptor_set_layout_create_info);
+
+		auto push_constant_range = vk::PushConstantRange()
+			.setStageFlags(vk::ShaderStageFlagBits::eCompute)
+			.setSize(sizeof(MipmapComputeSettings));
+
+		auto pipeline_layout_create_info = vk::PipelineLayoutCreateInfo()
+			.setSetLayouts(*gContext->mipmap_descriptor_set_layout)
+			.setPushConstantRanges(push_constant_range);
+
+		gContext->mipmap_pipeline_layout = gContext->device.createPipelineLayout(pipeline_layout_create_info);
+	}
 
-class ShaderVK : public ObjectVK
+	auto pipeline_state = MipmapPipelineStateVK{
+		.format = format,
+		.filter = filter
+	};
+
+	if (!gContext->mipmap_pipeline_states.contains(pipeline_state))
+	{
+		auto defines = GetMipmapComputeShaderDefines(ReversedPixelFormatMap.at(format), filter).value();
+		auto spirv = CompileGlslToSpirv(ShaderStage::Compute, MipmapComputeShaderCode, defines);
+
+		auto shader_module_create_info = vk::ShaderModuleCreateInfo()
+			.setCode(spirv);
+
+		auto shader_module = gContext->device.createShaderModule(shader_module_create_info);
+
+		auto shader_stage_create_info = vk::PipelineShaderStageCreateInfo()
+			.setStage(vk::ShaderStageFlagBits::eCompute)
+			.setModule(*shader_module)
+			.setPName("main");
+
+		auto compute_pipeline_create_info = vk::ComputePipelineCreateInfo()
+			.setStage(shader_stage_create_info)
+			.setLayout(*gContext->mipmap_pipeline_layout);
+
+		auto pipeline = gContext->device.createComputePipeline(nullptr, compute_pipeline_create_info);
+
+		gContext->mipmap_pipeline_states.insert({ pipeline_state, std::move(pipeline) });
+	}
+
+	return gContext->mipmap_pipeline_states.at(pipeline_state);
+}
+
+class ShaderVK
 {
 public:
-	const auto& getPipelineLayout() const { return mPipelineLayout; }
+	const auto& getPipelineLayout() const { return mPipelineLayout->pipeline_layout; }
 	const auto& getVertexShaderModule() const { return mVertexShaderModule; }
 	const auto& getFragmentShaderModule() const { return mFragmentShaderModule; }
-	const auto& getRequiredDescriptorBindings() const { return mRequiredDescriptorBindings; }
+	const auto& getRequiredDescriptorBindings() const { return mPipelineLayout->required_descriptor_bindings; }
+	const auto& getDescriptorUpdateTemplate() const { return mPipelineLayout->descriptor_update_template; }
+	const auto& getPushConstantRange() const { return mPipelineLayout->push_constant_range; }
+	auto usesBindlessTextures() const { return mPipelineLayout->bindless_textures; }
 
 private:
-	vk::raii::DescriptorSetLayout mDescriptorSetLayout = nullptr;
-	vk::raii::PipelineLayout mPipelineLayout = nullptr;
+	const PipelineLayoutVK* mPipelineLayout = nullptr;
 	vk::raii::ShaderModule mVertexShaderModule = nullptr;
 	vk::raii::ShaderModule mFragmentShaderModule = nullptr;
-	std::vector<vk::DescriptorSetLayoutBinding> mRequiredDescriptorBindings;
 
 public:
 	ShaderVK(const std::string& vertex_code, const std::string& fragment_code,
@@ -436,8 +1256,8 @@ public:
 		auto vertex_shader_spirv = CompileGlslToSpirv(ShaderStage::Vertex, vertex_code, defines);
 		auto fragment_shader_spirv = CompileGlslToSpirv(ShaderStage::Fragment, fragment_code, defines);
 
-		std::tie(mPipelineLayout, mDescriptorSetLayout, mRequiredDescriptorBindings) = CreatePipelineLayout({ 
-			vertex_shader_spirv, fragment_shader_spirv });
+		mPipelineLayout = &GetPipelineLayout(vk::PipelineBindPoint::eGraphics,
+			{ vertex_shader_spirv, fragment_shader_spirv });
 
 		auto vertex_shader_module_create_info = vk::ShaderModuleCreateInfo()
 			.setCode(vertex_shader_spirv);
@@ -450,44 +1270,52 @@ public:
 	}
 };
 
-class RaytracingShaderVK : public ObjectVK
+class RaytracingShaderVK
 {
 public:
 	const auto& getRaygenShaderModule() const { return mRaygenShaderModule; }
 	const auto& getMissShaderModules() const { return mMissShaderModules; }
-	const auto& getClosestHitShaderModule() const { return mClosestHitShaderModule; }
-	const auto& getPipelineLayout() const { return mPipelineLayout; }
-	const auto& getRequiredDescriptorBindings() const { return mRequiredDescriptorBindings; }
+	const auto& getClosestHitShaderModules() const { return mClosestHitShaderModules; }
+	const auto& getPipelineLayout() const { return mPipelineLayout->pipeline_layout; }
+	const auto& getRequiredDescriptorBindings() const { return mPipelineLayout->required_descriptor_bindings; }
+	const auto& getDescriptorUpdateTemplate() const { return mPipelineLayout->descriptor_update_template; }
+	const auto& getPushConstantRange() const { return mPipelineLayout->push_constant_range; }
+	auto usesBindlessTextures() const { return mPipelineLayout->bindless_textures; }
 
 private:
 	vk::raii::ShaderModule mRaygenShaderModule = nullptr;
 	std::vector<vk::raii::ShaderModule> mMissShaderModules;
-	vk::raii::ShaderModule mClosestHitShaderModule = nullptr;
-	vk::raii::DescriptorSetLayout mDescriptorSetLayout = nullptr;
-	vk::raii::PipelineLayout mPipelineLayout = nullptr;
-	std::vector<vk::DescriptorSetLayoutBinding> mRequiredDescriptorBindings;
+	std::vector<vk::raii::ShaderModule> mClosestHitShaderModules;
+	const PipelineLayoutVK* mPipelineLayout = nullptr;
 
 public:
 	RaytracingShaderVK(const std::string& raygen_code, const std::vector<std::string>& miss_codes,
-		const std::string& closesthit_code, std::vector<std::string> defines)
+		const std::vector<std::string>& closesthit_codes, std::vector<std::string> defines)
 	{
 		auto raygen_shader_spirv = CompileGlslToSpirv(ShaderStage::Raygen, raygen_code);
-		auto closesthit_shader_spirv = CompileGlslToSpirv(ShaderStage::ClosestHit, closesthit_code);
 
 		auto raygen_shader_module_create_info = vk::ShaderModuleCreateInfo()
 			.setCode(raygen_shader_spirv);
 
-		auto closesthit_shader_module_create_info = vk::ShaderModuleCreateInfo()
-			.setCode(closesthit_shader_spirv);
-
 		mRaygenShaderModule = gContext->device.createShaderModule(raygen_shader_module_create_info);
-		mClosestHitShaderModule = gContext->device.createShaderModule(closesthit_shader_module_create_info);
 
 		std::vector<std::vector<uint32_t>> spirvs = {
-			raygen_shader_spirv,
-			closesthit_shader_spirv
+			raygen_shader_spirv
 		};
 
+		for (const auto& closesthit_code : closesthit_codes)
+		{
+			auto closesthit_shader_spirv = CompileGlslToSpirv(ShaderStage::ClosestHit, closesthit_code);
+
+			auto closesthit_shader_module_create_info = vk::ShaderModuleCreateInfo()
+				.setCode(closesthit_shader_spirv);
+
+			auto closesthit_shader_module = gContext->device.createShaderModule(closesthit_shader_module_create_info);
+
+			mClosestHitShaderModules.push_back(std::move(closesthit_shader_module));
+			spirvs.push_back(closesthit_shader_spirv);
+		}
+
 		for (const auto& miss_code : miss_codes)
 		{
 			auto miss_shader_spirv = CompileGlslToSpirv(ShaderStage::Miss, miss_code);
@@ -501,11 +1329,11 @@ public:
 			spirvs.push_back(miss_shader_spirv);
 		}
 
-		std::tie(mPipelineLayout, mDescriptorSetLayout, mRequiredDescriptorBindings) = CreatePipelineLayout(spirvs);
+		mPipelineLayout = &GetPipelineLayout(vk::PipelineBindPoint::eRayTracingKHR, spirvs);
 	}
 };
 
-class TextureVK : public ObjectVK
+class TextureVK
 {
 public:
 	auto getImage() const { return mImagePtr; }
@@ -519,18 +1347,22 @@ private:
 	std::optional<vk::raii::DeviceMemory> mDeviceMemory;
 	vk::Image mImagePtr;
 	vk::raii::ImageView mImageView = nullptr;
+	std::vector<vk::raii::ImageView> mMipImageViews;
 	uint32_t mWidth = 0;
 	uint32_t mHeight = 0;
 	uint32_t mMipCount = 0;
 	vk::Format mFormat;
-	vk::ImageLayout mCurrentState = vk::ImageLayout::eUndefined;
+	std::vector<vk::ImageLayout> mMipStates;
+	UploadId mUploadId = 0;
+	std::optional<uint32_t> mBindlessIndex;
+	vk::DeviceSize mMemorySize = 0;
 
 public:
 	TextureVK(uint32_t width, uint32_t height, vk::Format format, uint32_t mip_count) :
 		mWidth(width),
 		mHeight(height),
-		mFormat(format),
-		mMipCount(mip_count)
+		mMipCount(mip_count),
+		mFormat(format)
 	{
 		auto usage = 
 			vk::ImageUsageFlagBits::eSampled |
@@ -543,22 +1375,44 @@ public:
 			vk::ImageAspectFlagBits::eColor, mip_count);
 
 		mImagePtr = *mImage.value();
+		mMipStates.resize(mip_count, vk::ImageLayout::eUndefined);
+
+		mMemorySize = mImage->getMemoryRequirements().size;
+		AddMemoryUsage(gContext->memory_stats.textures, mMemorySize);
+
+		if (gContext->bindless_textures_enabled)
+		{
+			mBindlessIndex = AddBindlessTexture(*mImageView);
+			gContext->bindless_textures_to_restore.insert(this);
+		}
 	}
 
 	TextureVK(uint32_t width, uint32_t height, vk::Format format, vk::Image image) :
+		mImagePtr(image),
 		mWidth(width),
 		mHeight(height),
-		mFormat(format),
-		mImagePtr(image)
+		mMipCount(1),
+		mFormat(format)
 	{
 		mImageView = CreateImageView(image, format, vk::ImageAspectFlagBits::eColor);
+		mMipStates.resize(mMipCount, vk::ImageLayout::eUndefined);
 	}
 
 	~TextureVK()
 	{
+		WaitUpload(mUploadId);
+
+		if (mBindlessIndex.has_value())
+		{
+			RemoveBindlessTexture(mBindlessIndex.value());
+			gContext->bindless_textures_to_restore.erase(this);
+		}
+
 		if (mImage.has_value())
 			DestroyStaging(std::move(mImage.value()));
 
+		RemoveMemoryUsage(gContext->memory_stats.textures, mMemorySize);
+
 		if (mDeviceMemory.has_value())
 			DestroyStaging(std::move(mDeviceMemory.value()));
 	}
@@ -577,7 +1431,8 @@ public:
 
 		WriteToBuffer(upload_buffer_memory, memory, size);
 
-		ensureState(gContext->getCurrentFrame().command_buffer, vk::ImageLayout::eTransferDstOptimal);
+		ensureState(vk::ImageLayout::eTransferDstOptimal, mip_level, 1);
+		FlushBarriers(gContext->getCurrentFrame().command_buffer);
 
 		auto image_subresource_layers = vk::ImageSubresourceLayers()
 			.setAspectMask(vk::ImageAspectFlagBits::eColor)
@@ -595,16 +1450,89 @@ public:
 		DestroyStaging(std::move(upload_buffer_memory));
 	}
 
-	std::vector<uint8_t> read(uint32_t mip_level)
+	UploadId writeAsync(const void* memory, uint32_t mip_level)
 	{
-		EnsureRenderPassDeactivated();
-		gContext->getCurrentFrame().command_buffer.end();
+		WaitUpload(mUploadId);
+
+		auto format = ReversedPixelFormatMap.at(mFormat);
+		auto channels = GetFormatChannelsCount(format);
+		auto channel_size = GetFormatChannelSize(format);
+		auto width = GetMipWidth(mWidth, mip_level);
+		auto height = GetMipHeight(mHeight, mip_level);
+		auto size = width * height * channels * channel_size;
+
+		auto [upload_buffer, upload_buffer_memory] = CreateBuffer(size, vk::BufferUsageFlagBits::eTransferSrc);
+
+		WriteToBuffer(upload_buffer_memory, memory, size);
+
+		auto& upload = BeginUpload();
+
+		auto subresource_range = vk::ImageSubresourceRange()
+			.setAspectMask(vk::ImageAspectFlagBits::eColor)
+			.setBaseMipLevel(mip_level)
+			.setLevelCount(1)
+			.setLayerCount(1);
+
+		// the whole mip is overwritten, so its old contents need no ownership transfer to the transfer queue
+		auto transition_barrier = vk::ImageMemoryBarrier2()
+			.setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite)
+			.setOldLayout(vk::ImageLayout::eUndefined)
+			.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+			.setImage(mImagePtr)
+			.setSubresourceRange(subresource_range);
+
+		upload.command_buffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(transition_barrier));
+
+		auto image_subresource_layers = vk::ImageSubresourceLayers()
+			.setAspectMask(vk::ImageAspectFlagBits::eColor)
+			.setMipLevel(mip_level)
+			.setLayerCount(1);
+
+		auto region = vk::BufferImageCopy()
+			.setImageSubresource(image_subresource_layers)
+			.setImageExtent({ width, height, 1 });
+
+		upload.command_buffer.copyBufferToImage(*upload_buffer, mImagePtr, vk::ImageLayout::eTransferDstOptimal, { region });
+
+		auto ownership_barrier = vk::ImageMemoryBarrier2()
+			.setOldLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setNewLayout(vk::ImageLayout::eTransferDstOptimal)
+			.setSrcQueueFamilyIndex(gContext->transfer_queue_family_index.value())
+			.setDstQueueFamilyIndex(gContext->queue_family_index)
+			.setImage(mImagePtr)
+			.setSubresourceRange(subresource_range);
+
+		auto release_barrier = vk::ImageMemoryBarrier2(ownership_barrier)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+
+		// the mip stays in the transfer layout, the transition on its next use waits for transfers
+		auto acquire_barrier = vk::ImageMemoryBarrier2(ownership_barrier)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eTransfer)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+
+		upload.command_buffer.pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(release_barrier));
+		upload.acquire_image_barriers.push_back(acquire_barrier);
+		upload.staging_objects.push_back(std::move(upload_buffer));
+		upload.staging_objects.push_back(std::move(upload_buffer_memory));
 
-		auto submit_info = vk::SubmitInfo()
-			.setCommandBuffers(*gContext->getCurrentFrame().command_buffer);
+		mMipStates.at(mip_level) = vk::ImageLayout::eTransferDstOptimal;
 
-		gContext->queue.submit(submit_info);
-		gContext->queue.waitIdle();
+		if (mBindlessIndex.has_value())
+			gContext->bindless_textures_to_restore.insert(this);
+		mUploadId = upload.id;
+
+		EndUpload(upload);
+
+		return mUploadId;
+	}
+
+	std::vector<uint8_t> read(uint32_t mip_level)
+	{
+		EnsureRenderPassDeactivated();
 
 		auto format = ReversedPixelFormatMap.at(mFormat);
 		auto channels_count = GetFormatChannelsCount(format);
@@ -634,32 +1562,106 @@ public:
 			.setDstBuffer(*staging_buffer)
 			.setRegions(region);
 
-		OneTimeSubmit([&](auto& cmdbuf) {
-			ensureState(cmdbuf, vk::ImageLayout::eTransferSrcOptimal);
-			cmdbuf.copyImageToBuffer2(copy_image_to_buffer_info);
-		});
+		auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+		ensureState(vk::ImageLayout::eTransferSrcOptimal, mip_level, 1);
+		FlushBarriers(cmdbuf);
+		cmdbuf.copyImageToBuffer2(copy_image_to_buffer_info);
+
+		FlushCommandBuffer();
 
 		std::vector<uint8_t> result(size);
 		auto ptr = staging_buffer_memory.mapMemory(0, size);
 		memcpy(result.data(), ptr, size);
 		staging_buffer_memory.unmapMemory();
 
-		auto begin_info = vk::CommandBufferBeginInfo()
-			.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+		return result;
+	}
 
-		gContext->getCurrentFrame().command_buffer.begin(begin_info);
+	void generateMips(MipmapFilter filter)
+	{
+		EnsureRenderPassDeactivated();
 
-		return result;
+		if (IsMipmapComputeSupported(mFormat, filter))
+			generateMipsWithCompute(filter);
+		else
+			generateMipsWithBlit();
 	}
 
-	void generateMips()
+	void generateMipsWithCompute(MipmapFilter filter)
 	{
-		ensureState(gContext->getCurrentFrame().command_buffer, vk::ImageLayout::eTransferSrcOptimal);
+		const auto& pipeline = GetMipmapPipeline(mFormat, filter);
+		const auto& pipeline_layout = gContext->mipmap_pipeline_layout;
+		auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+		EnsureMemoryState(vk::PipelineStageFlagBits2::eComputeShader);
+		ensureState(vk::ImageLayout::eGeneral);
+		FlushBarriers(cmdbuf);
+
+		cmdbuf.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+
+		for (const auto& pass : MakeMipmapComputePasses(mWidth, mHeight, mMipCount, filter))
+		{
+			std::vector<vk::DescriptorImageInfo> image_infos;
+
+			auto add_image_info = [&](uint32_t mip_level) {
+				auto image_info = vk::DescriptorImageInfo()
+					.setImageView(*getMipImageView(mip_level))
+					.setImageLayout(vk::ImageLayout::eGeneral);
+
+				image_infos.push_back(image_info);
+			};
+
+			add_image_info(pass.src_mip_level);
+
+			// slots beyond the pass are not written by the shader, but still must be valid
+			for (uint32_t i = 0; i < MipmapComputeMaxMipsPerPass; i++)
+				add_image_info(pass.src_mip_level + 1 + std::min(i, pass.mip_count - 1));
+
+			std::vector<vk::WriteDescriptorSet> writes;
+
+			for (uint32_t i = 0; i < image_infos.size(); i++)
+			{
+				auto write = vk::WriteDescriptorSet()
+					.setDstBinding(i)
+					.setDescriptorCount(1)
+					.setDescriptorType(vk::DescriptorType::eStorageImage)
+					.setPImageInfo(&image_infos.at(i));
+
+				writes.push_back(write);
+			}
+
+			cmdbuf.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, *pipeline_layout, 0, writes);
 
+			auto settings = MipmapComputeSettings{
+				.src_size = {
+					(int32_t)GetMipWidth(mWidth, pass.src_mip_level),
+					(int32_t)GetMipHeight(mHeight, pass.src_mip_level)
+				},
+				.mip_count = (int32_t)pass.mip_count
+			};
+
+			cmdbuf.pushConstants<MipmapComputeSettings>(*pipeline_layout, vk::ShaderStageFlagBits::eCompute, 0, settings);
+			cmdbuf.dispatch(pass.group_count_x, pass.group_count_y, 1);
+
+			SetMemoryBarrier(cmdbuf, vk::PipelineStageFlagBits2::eComputeShader, vk::PipelineStageFlagBits2::eComputeShader);
+		}
+
+		// push constants of the mipmap pipeline replaced the ones of the current shader
+		gContext->push_constants_dirty = true;
+	}
+
+	void generateMipsWithBlit()
+	{
 		for (uint32_t i = 1; i < mMipCount; i++)
 		{
-			SetImageMemoryBarrier(gContext->getCurrentFrame().command_buffer, mImagePtr, vk::ImageAspectFlagBits::eColor,
-				vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, i, 1);
+			ensureState(vk::ImageLayout::eTransferSrcOptimal, i - 1, 1);
+
+			// previous contents of the mip are overwritten entirely
+			mMipStates.at(i) = vk::ImageLayout::eUndefined;
+			ensureState(vk::ImageLayout::eTransferDstOptimal, i, 1);
+
+			FlushBarriers(gContext->getCurrentFrame().command_buffer);
 
 			auto src_subresource = vk::ImageSubresourceLayers()
 				.setAspectMask(vk::ImageAspectFlagBits::eColor)
@@ -679,23 +1681,69 @@ public:
 
 			gContext->getCurrentFrame().command_buffer.blitImage(mImagePtr, vk::ImageLayout::eTransferSrcOptimal,
 				mImagePtr, vk::ImageLayout::eTransferDstOptimal, { mip_region }, vk::Filter::eLinear);
+		}
+	}
+
+	void ensureState(vk::ImageLayout state)
+	{
+		ensureState(state, 0, mMipCount);
+	}
+
+	void ensureState(vk::ImageLayout state, uint32_t base_mip_level, uint32_t level_count)
+	{
+		WaitUpload(mUploadId);
+
+		// barriers are only queued here, neighbouring mips that share a layout get one barrier
+
+		auto end_mip_level = base_mip_level + level_count;
+		auto mip_level = base_mip_level;
+
+		while (mip_level < end_mip_level)
+		{
+			auto old_state = mMipStates.at(mip_level);
+			auto range_begin = mip_level;
+
+			while (mip_level < end_mip_level && mMipStates.at(mip_level) == old_state)
+			{
+				mMipStates.at(mip_level) = state;
+				mip_level++;
+			}
 
-			SetImageMemoryBarrier(gContext->getCurrentFrame().command_buffer, mImagePtr, vk::ImageAspectFlagBits::eColor,
-				vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal, i, 1);
+			if (old_state == state)
+				continue;
+
+			AddImageMemoryBarrier(mImagePtr, vk::ImageAspectFlagBits::eColor, old_state, state, range_begin,
+				mip_level - range_begin);
 		}
+
+		// the bindless array expects every registered texture in the general layout when it is read
+		if (mBindlessIndex.has_value() && state != vk::ImageLayout::eGeneral)
+			gContext->bindless_textures_to_restore.insert(this);
 	}
 
-	void ensureState(const vk::raii::CommandBuffer& cmdbuf, vk::ImageLayout state)
+	uint32_t getBindlessIndex() const
 	{
-		if (mCurrentState == state)
-			return;
+		// registered on creation when bindless textures are enabled
+		assert(mBindlessIndex.has_value());
+		return mBindlessIndex.value();
+	}
 
-		SetImageMemoryBarrier(cmdbuf, mImagePtr, vk::ImageAspectFlagBits::eColor, mCurrentState, state);
-		mCurrentState = state;
+	const vk::raii::ImageView& getMipImageView(uint32_t mip_level)
+	{
+		if (mMipImageViews.empty())
+		{
+			for (uint32_t i = 0; i < mMipCount; i++)
+			{
+				auto image_view = CreateImageView(mImagePtr, mFormat, vk::ImageAspectFlagBits::eColor, 1, i);
+				mMipImageViews.push_back(std::move(image_view));
+			}
+		}
+
+		return mMipImageViews.at(mip_level);
 	}
 };
 
-class RenderTargetVK : public ObjectVK
+class RenderTargetVK
 {
 public:
 	auto getTexture() const { return mTexture; }
@@ -709,6 +1757,8 @@ private:
 	vk::raii::Image mDepthStencilImage = nullptr;
 	vk::raii::ImageView mDepthStencilView = nullptr;
 	vk::raii::DeviceMemory mDepthStencilMemory = nullptr;
+	vk::ImageLayout mDepthStencilState = vk::ImageLayout::eUndefined;
+	vk::DeviceSize mMemorySize = 0;
 
 public:
 	RenderTargetVK(uint32_t width, uint32_t height, TextureVK* _texture) : mTexture(_texture)
@@ -716,57 +1766,279 @@ public:
 		std::tie(mDepthStencilImage, mDepthStencilMemory, mDepthStencilView) = CreateImage(width, height, mDepthStencilFormat,
 			vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil);
 
-		OneTimeSubmit([&](auto& cmdbuf) {
-			SetImageMemoryBarrier(cmdbuf, *mDepthStencilImage, mDepthStencilFormat, vk::ImageLayout::eUndefined,
-				vk::ImageLayout::eDepthStencilAttachmentOptimal);
-		});
+		mMemorySize = mDepthStencilImage.getMemoryRequirements().size;
+		AddMemoryUsage(gContext->memory_stats.render_targets, mMemorySize);
+	}
+
+	~RenderTargetVK()
+	{
+		RemoveMemoryUsage(gContext->memory_stats.render_targets, mMemorySize);
+	}
+
+	void ensureDepthStencilState(vk::ImageLayout state)
+	{
+		if (mDepthStencilState == state)
+			return;
+
+		auto aspect_mask = vk::ImageAspectFlags(vk::ImageAspectFlagBits::eDepth);
+
+		if (mDepthStencilFormat == vk::Format::eD32SfloatS8Uint || mDepthStencilFormat == vk::Format::eD24UnormS8Uint)
+			aspect_mask |= vk::ImageAspectFlagBits::eStencil;
+
+		AddImageMemoryBarrier(*mDepthStencilImage, aspect_mask, mDepthStencilState, state, 0, 1);
+		mDepthStencilState = state;
 	}
 };
 
-class BufferVK : public ObjectVK
+static vk::BufferUsageFlags GetAccelerationStructureBuildInputUsage()
+{
+	if (!gContext->raytracing_enabled)
+		return {};
+
+	return vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR |
+		vk::BufferUsageFlagBits::eShaderDeviceAddress;
+}
+
+static std::tuple<vk::PipelineStageFlags2, vk::AccessFlags2> GetBufferUsageStageAccess(vk::BufferUsageFlags usage)
+{
+	// every buffer is written by copies
+	vk::PipelineStageFlags2 stage_mask = vk::PipelineStageFlagBits2::eCopy;
+	vk::AccessFlags2 access_mask = vk::AccessFlagBits2::eTransferWrite;
+
+	vk::PipelineStageFlags2 shader_stage_mask = vk::PipelineStageFlagBits2::eVertexShader |
+		vk::PipelineStageFlagBits2::eFragmentShader;
+
+	if (gContext->raytracing_enabled)
+		shader_stage_mask |= vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+
+	if (usage & vk::BufferUsageFlagBits::eVertexBuffer)
+	{
+		stage_mask |= vk::PipelineStageFlagBits2::eVertexAttributeInput;
+		access_mask |= vk::AccessFlagBits2::eVertexAttributeRead;
+	}
+
+	if (usage & vk::BufferUsageFlagBits::eIndexBuffer)
+	{
+		stage_mask |= vk::PipelineStageFlagBits2::eIndexInput;
+		access_mask |= vk::AccessFlagBits2::eIndexRead;
+	}
+
+	if (usage & vk::BufferUsageFlagBits::eUniformBuffer)
+	{
+		stage_mask |= shader_stage_mask;
+		access_mask |= vk::AccessFlagBits2::eUniformRead;
+	}
+
+	if (usage & vk::BufferUsageFlagBits::eStorageBuffer)
+	{
+		stage_mask |= shader_stage_mask;
+		access_mask |= vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite;
+	}
+
+	if (usage & vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR)
+	{
+		stage_mask |= vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR;
+		access_mask |= vk::AccessFlagBits2::eShaderRead;
+	}
+
+	return { stage_mask, access_mask };
+}
+
+class BufferVK
 {
 public:
 	const auto& getBuffer() const { return mBuffer; }
 
+	vk::Buffer getBindBuffer() const { return mFrameUpload.has_value() ? mFrameUpload->buffer : *mBuffer; }
+	vk::DeviceSize getBindOffset() const { return mFrameUpload.has_value() ? mFrameUpload->offset : 0; }
+	vk::DeviceSize getBindRange() const { return mFrameUpload.has_value() ? mFrameUpload->size : VK_WHOLE_SIZE; }
+
+private:
+	struct FrameUpload
+	{
+		vk::Buffer buffer;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+	};
+
 private:
 	vk::raii::Buffer mBuffer = nullptr;
 	vk::raii::DeviceMemory mDeviceMemory = nullptr;
+	std::optional<FrameUpload> mFrameUpload;
+	UploadId mUploadId = 0;
+	vk::BufferUsageFlags mUsage;
+	vk::DeviceSize mMemorySize = 0;
+
+public:
+	BufferVK(size_t size, vk::BufferUsageFlags usage) : mUsage(usage)
+	{
+		usage |= vk::BufferUsageFlagBits::eTransferDst;
+		std::tie(mBuffer, mDeviceMemory) = CreateBuffer(size, usage);
+
+		mMemorySize = mBuffer.getMemoryRequirements().size;
+		AddMemoryUsage(gContext->memory_stats.buffers, mMemorySize);
+	}
+
+	~BufferVK()
+	{
+		WaitUpload(mUploadId);
+
+		if (mFrameUpload.has_value())
+			std::erase(gContext->buffers_with_frame_uploads, this);
+
+		DestroyStaging(std::move(mBuffer));
+		DestroyStaging(std::move(mDeviceMemory));
+
+		RemoveMemoryUsage(gContext->memory_stats.buffers, mMemorySize);
+	}
+
+	void ensureUploadCompleted() const
+	{
+		WaitUpload(mUploadId);
+	}
+
+	void write(const void* memory, size_t size)
+	{
+		WaitUpload(mUploadId);
+
+		// inside of a render pass the new contents are placed in frame upload memory and bound from there,
+		// so the pass is not split, they are copied into the buffer when the pass ends
+		if (gContext->render_pass_active)
+		{
+			auto [buffer, offset] = WriteToFrameUploadMemory(memory, size);
+
+			if (!mFrameUpload.has_value())
+				gContext->buffers_with_frame_uploads.push_back(this);
+
+			mFrameUpload = FrameUpload{
+				.buffer = buffer,
+				.offset = offset,
+				.size = size
+			};
+			return;
+		}
+
+		EnsureRenderPassDeactivated();
+		EnsureMemoryState(vk::PipelineStageFlagBits2::eTransfer);
+		FlushBarriers(gContext->getCurrentFrame().command_buffer);
+
+		if (size < 65536)
+		{
+			gContext->getCurrentFrame().command_buffer.updateBuffer<uint8_t>(*mBuffer, 0, { (uint32_t)size, (uint8_t*)memory });
+			return;
+		}
+
+		auto [staging_buffer, staging_buffer_memory] = CreateBuffer(size, vk::BufferUsageFlagBits::eTransferSrc);
+
+		WriteToBuffer(staging_buffer_memory, memory, size);
+
+		auto region = vk::BufferCopy()
+			.setSize(size);
+
+		gContext->getCurrentFrame().command_buffer.copyBuffer(*staging_buffer, *mBuffer, { region });
+		
+		DestroyStaging(std::move(staging_buffer));
+		DestroyStaging(std::move(staging_buffer_memory));
+	}
+
+	UploadId writeAsync(const void* memory, size_t size)
+	{
+		WaitUpload(mUploadId);
+
+		// contents staged for the open pass would be copied over the async write when the pass ends,
+		// so they are dropped when the write covers them and resolved before it otherwise
+		if (mFrameUpload.has_value())
+		{
+			if (size >= mFrameUpload->size)
+			{
+				std::erase(gContext->buffers_with_frame_uploads, this);
+				mFrameUpload.reset();
+
+				gContext->vertex_buffers_dirty = true;
+				gContext->index_buffer_dirty = true;
+				gContext->graphics_descriptors_dirty = true;
+			}
+			else
+			{
+				EnsureRenderPassDeactivated();
+			}
+		}
+
+		auto [upload_buffer, upload_buffer_memory] = CreateBuffer(size, vk::BufferUsageFlagBits::eTransferSrc);
+
+		WriteToBuffer(upload_buffer_memory, memory, size);
+
+		// the release is recorded into the frame that the upload waits for
+		assert(gContext->working);
+
+		auto& upload = BeginUpload();
+
+		auto [usage_stage_mask, usage_access_mask] = GetBufferUsageStageAccess(mUsage);
+
+		auto to_transfer_barrier = vk::BufferMemoryBarrier2()
+			.setSrcQueueFamilyIndex(gContext->queue_family_index)
+			.setDstQueueFamilyIndex(gContext->transfer_queue_family_index.value())
+			.setBuffer(*mBuffer)
+			.setSize(VK_WHOLE_SIZE);
+
+		auto graphics_release_barrier = vk::BufferMemoryBarrier2(to_transfer_barrier)
+			.setSrcStageMask(usage_stage_mask)
+			.setSrcAccessMask(usage_access_mask & (vk::AccessFlagBits2::eTransferWrite |
+				vk::AccessFlagBits2::eShaderStorageWrite));
+
+		auto transfer_acquire_barrier = vk::BufferMemoryBarrier2(to_transfer_barrier)
+			.setDstStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setDstAccessMask(vk::AccessFlagBits2::eTransferWrite);
+
+		gContext->pending_release_buffer_barriers.push_back(graphics_release_barrier);
+		upload.command_buffer.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(transfer_acquire_barrier));
+
+		auto region = vk::BufferCopy()
+			.setSize(size);
+
+		upload.command_buffer.copyBuffer(*upload_buffer, *mBuffer, { region });
+
+		auto to_graphics_barrier = vk::BufferMemoryBarrier2()
+			.setSrcQueueFamilyIndex(gContext->transfer_queue_family_index.value())
+			.setDstQueueFamilyIndex(gContext->queue_family_index)
+			.setBuffer(*mBuffer)
+			.setSize(VK_WHOLE_SIZE);
+
+		auto transfer_release_barrier = vk::BufferMemoryBarrier2(to_graphics_barrier)
+			.setSrcStageMask(vk::PipelineStageFlagBits2::eCopy)
+			.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+
+		auto graphics_acquire_barrier = vk::BufferMemoryBarrier2(to_graphics_barrier)
+			.setDstStageMask(usage_stage_mask)
+			.setDstAccessMask(usage_access_mask);
 
-public:
-	BufferVK(size_t size, vk::BufferUsageFlags usage)
-	{
-		usage |= vk::BufferUsageFlagBits::eTransferDst;
-		std::tie(mBuffer, mDeviceMemory) = CreateBuffer(size, usage);
-	}
+		upload.command_buffer.pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(transfer_release_barrier));
+		upload.acquire_buffer_barriers.push_back(graphics_acquire_barrier);
+		upload.staging_objects.push_back(std::move(upload_buffer));
+		upload.staging_objects.push_back(std::move(upload_buffer_memory));
 
-	~BufferVK()
-	{
-		DestroyStaging(std::move(mBuffer));
-		DestroyStaging(std::move(mDeviceMemory));
-	}
+		mUploadId = upload.id;
 
-	void write(const void* memory, size_t size)
-	{
-		EnsureRenderPassDeactivated();
-		EnsureMemoryState(gContext->getCurrentFrame().command_buffer, vk::PipelineStageFlagBits2::eTransfer);
+		EndUpload(upload);
 
-		if (size < 65536)
-		{
-			gContext->getCurrentFrame().command_buffer.updateBuffer<uint8_t>(*mBuffer, 0, { (uint32_t)size, (uint8_t*)memory });
-			return;
-		}
+		return mUploadId;
+	}
 
-		auto [staging_buffer, staging_buffer_memory] = CreateBuffer(size, vk::BufferUsageFlagBits::eTransferSrc);
+	void resolveFrameUpload()
+	{
+		assert(!gContext->render_pass_active);
+		assert(mFrameUpload.has_value());
 
-		WriteToBuffer(staging_buffer_memory, memory, size);
+		EnsureMemoryState(vk::PipelineStageFlagBits2::eTransfer);
+		FlushBarriers(gContext->getCurrentFrame().command_buffer);
 
 		auto region = vk::BufferCopy()
-			.setSize(size);
+			.setSrcOffset(mFrameUpload->offset)
+			.setSize(mFrameUpload->size);
 
-		gContext->getCurrentFrame().command_buffer.copyBuffer(*staging_buffer, *mBuffer, { region });
-		
-		DestroyStaging(std::move(staging_buffer));
-		DestroyStaging(std::move(staging_buffer_memory));
+		gContext->getCurrentFrame().command_buffer.copyBuffer(mFrameUpload->buffer, *mBuffer, { region });
+
+		mFrameUpload.reset();
 	}
 };
 
@@ -780,7 +2052,8 @@ private:
 	size_t mStride = 0;
 
 public:
-	VertexBufferVK(size_t size, size_t stride) : BufferVK(size, vk::BufferUsageFlagBits::eVertexBuffer),
+	VertexBufferVK(size_t size, size_t stride) : BufferVK(size, vk::BufferUsageFlagBits::eVertexBuffer |
+		GetAccelerationStructureBuildInputUsage()),
 		mStride(stride)
 	{
 	}
@@ -796,7 +2069,8 @@ private:
 	size_t mStride = 0;
 
 public:
-	IndexBufferVK(size_t size, size_t stride) : BufferVK(size, vk::BufferUsageFlagBits::eIndexBuffer),
+	IndexBufferVK(size_t size, size_t stride) : BufferVK(size, vk::BufferUsageFlagBits::eIndexBuffer |
+		GetAccelerationStructureBuildInputUsage()),
 		mStride(stride)
 	{
 	}
@@ -823,41 +2097,162 @@ static vk::IndexType GetIndexTypeFromStride(size_t stride)
 	return stride == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
 }
 
-class BottomLevelAccelerationStructureVK : public ObjectVK
+class BottomLevelAccelerationStructureVK
 {
 public:
 	const auto& getBlas() const { return mBlas; }
+	auto getBuildScratchSize() const { return mBuildScratchSize; }
+	auto isCompactionAllowed() const { return (bool)(mBuildFlags & vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction); }
+	bool readsBuffer(const BufferVK* buffer) const { return std::ranges::find(mSourceBuffers, buffer) != mSourceBuffers.end(); }
 
 private:
 	vk::raii::AccelerationStructureKHR mBlas = nullptr;
 	vk::raii::Buffer mBlasBuffer = nullptr;
 	vk::raii::DeviceMemory mBlasMemory = nullptr;
+	vk::AccelerationStructureGeometryKHR mGeometry;
+	vk::BuildAccelerationStructureFlagsKHR mBuildFlags;
+	vk::DeviceSize mBuildScratchSize = 0;
+	uint32_t mPrimitiveCount = 0;
+	std::vector<VulkanObject> mBuildInputs;
+	std::vector<const BufferVK*> mSourceBuffers;
+	vk::DeviceSize mMemorySize = 0;
 
 public:
 	BottomLevelAccelerationStructureVK(const void* vertex_memory, uint32_t vertex_count, uint32_t vertex_stride,
-		const void* index_memory, uint32_t index_count, uint32_t index_stride, const glm::mat4& _transform)
+		const void* index_memory, uint32_t index_count, uint32_t index_stride, const glm::mat4& transform,
+		const AccelerationStructureBuildOptions& options)
 	{
-		auto transform = glm::transpose(_transform);
-
 		auto [vertex_buffer, vertex_buffer_memory] = CreateBuffer(vertex_count * vertex_stride,
 			vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
 		auto [index_buffer, index_buffer_memory] = CreateBuffer(index_count * index_stride,
 			vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
 
-		auto [transform_buffer, transform_buffer_memory] = CreateBuffer(sizeof(transform), 
-			vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
-
 		WriteToBuffer(vertex_buffer_memory, vertex_memory, vertex_count * vertex_stride);
 		WriteToBuffer(index_buffer_memory, index_memory, index_count * index_stride);
-		WriteToBuffer(transform_buffer_memory, &transform, sizeof(transform));
 
 		auto vertex_buffer_device_address = GetBufferDeviceAddress(*vertex_buffer);
 		auto index_buffer_device_address = GetBufferDeviceAddress(*index_buffer);
+
+		mBuildInputs.push_back(std::move(vertex_buffer));
+		mBuildInputs.push_back(std::move(vertex_buffer_memory));
+		mBuildInputs.push_back(std::move(index_buffer));
+		mBuildInputs.push_back(std::move(index_buffer_memory));
+
+		init(vertex_buffer_device_address, vertex_count, vertex_stride, vk::Format::eR32G32B32Sfloat,
+			index_buffer_device_address, index_count, index_stride, transform, options);
+	}
+
+	BottomLevelAccelerationStructureVK(const VertexBufferVK& vertex_buffer, uint32_t vertex_count, uint32_t vertex_offset,
+		uint32_t vertex_stride, VertexFormat vertex_format, const IndexBufferVK& index_buffer, uint32_t index_count,
+		uint32_t index_offset, uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options)
+	{
+		auto format = VertexFormatMap.at(vertex_format);
+
+		if (!(gContext->physical_device.getFormatProperties(format).bufferFeatures &
+			vk::FormatFeatureFlagBits::eAccelerationStructureVertexBufferKHR))
+			throw std::runtime_error("vertex format is not supported for acceleration structure builds");
+
+		vertex_buffer.ensureUploadCompleted();
+		index_buffer.ensureUploadCompleted();
+
+		mSourceBuffers = { &vertex_buffer, &index_buffer };
+
+		auto vertex_buffer_device_address = GetBufferDeviceAddress(*vertex_buffer.getBuffer()) + vertex_offset;
+		auto index_buffer_device_address = GetBufferDeviceAddress(*index_buffer.getBuffer()) + index_offset;
+
+		init(vertex_buffer_device_address, vertex_count, vertex_stride, format, index_buffer_device_address,
+			index_count, index_stride, transform, options);
+	}
+
+	~BottomLevelAccelerationStructureVK()
+	{
+		releaseBuildInputs();
+		DestroyStaging(std::move(mBlas));
+		DestroyStaging(std::move(mBlasBuffer));
+		DestroyStaging(std::move(mBlasMemory));
+
+		RemoveMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
+	}
+
+	vk::AccelerationStructureBuildGeometryInfoKHR getBuildGeometryInfo() const
+	{
+		return vk::AccelerationStructureBuildGeometryInfoKHR()
+			.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+			.setFlags(mBuildFlags)
+			.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
+			.setDstAccelerationStructure(*mBlas)
+			.setGeometries(mGeometry);
+	}
+
+	vk::AccelerationStructureBuildRangeInfoKHR getBuildRangeInfo() const
+	{
+		return vk::AccelerationStructureBuildRangeInfoKHR()
+			.setPrimitiveCount(mPrimitiveCount);
+	}
+
+	void releaseBuildInputs()
+	{
+		for (auto& build_input : mBuildInputs)
+		{
+			DestroyStaging(std::move(build_input));
+		}
+
+		mBuildInputs.clear();
+		mSourceBuffers.clear();
+	}
+
+	void compact(const vk::raii::CommandBuffer& cmdbuf, vk::DeviceSize compacted_size)
+	{
+		auto [blas_buffer, blas_memory] = CreateBuffer(compacted_size,
+			vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR);
+
+		auto create_info = vk::AccelerationStructureCreateInfoKHR()
+			.setBuffer(*blas_buffer)
+			.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
+			.setSize(compacted_size);
+
+		auto blas = gContext->device.createAccelerationStructureKHR(create_info);
+
+		auto copy_info = vk::CopyAccelerationStructureInfoKHR()
+			.setSrc(*mBlas)
+			.setDst(*blas)
+			.setMode(vk::CopyAccelerationStructureModeKHR::eCompact);
+
+		cmdbuf.copyAccelerationStructureKHR(copy_info);
+
+		DestroyStaging(std::move(mBlas));
+		DestroyStaging(std::move(mBlasBuffer));
+		DestroyStaging(std::move(mBlasMemory));
+
+		mBlas = std::move(blas);
+		mBlasBuffer = std::move(blas_buffer);
+		mBlasMemory = std::move(blas_memory);
+
+		RemoveMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
+		mMemorySize = mBlasBuffer.getMemoryRequirements().size;
+		AddMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
+	}
+
+private:
+	void init(vk::DeviceAddress vertex_buffer_device_address, uint32_t vertex_count, uint32_t vertex_stride,
+		vk::Format vertex_format, vk::DeviceAddress index_buffer_device_address, uint32_t index_count,
+		uint32_t index_stride, const glm::mat4& _transform, const AccelerationStructureBuildOptions& options)
+	{
+		auto transform = glm::transpose(_transform);
+
+		auto [transform_buffer, transform_buffer_memory] = CreateBuffer(sizeof(transform), 
+			vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+
+		WriteToBuffer(transform_buffer_memory, &transform, sizeof(transform));
+
 		auto transform_buffer_device_address = GetBufferDeviceAddress(*transform_buffer);
 
+		mBuildInputs.push_back(std::move(transform_buffer));
+		mBuildInputs.push_back(std::move(transform_buffer_memory));
+
 		auto triangles = vk::AccelerationStructureGeometryTrianglesDataKHR()
-			.setVertexFormat(vk::Format::eR32G32B32Sfloat)
+			.setVertexFormat(vertex_format)
 			.setVertexData(vertex_buffer_device_address)
 			.setMaxVertex(vertex_count)
 			.setVertexStride(vertex_stride)
@@ -868,59 +2263,43 @@ public:
 		auto geometry_data = vk::AccelerationStructureGeometryDataKHR()
 			.setTriangles(triangles);
 
-		auto geometry = vk::AccelerationStructureGeometryKHR()
+		mGeometry = vk::AccelerationStructureGeometryKHR()
 			.setGeometryType(vk::GeometryTypeKHR::eTriangles)
 			.setGeometry(geometry_data)
 			.setFlags(vk::GeometryFlagBitsKHR::eOpaque);
 
-		auto build_geometry_info = vk::AccelerationStructureBuildGeometryInfoKHR()
-			.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
-			.setFlags(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace)
-			.setGeometries(geometry);
+		mPrimitiveCount = index_count / 3;
+
+		mBuildFlags = options.preference == AccelerationStructureBuildPreference::FastBuild ?
+			vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastBuild :
+			vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
+
+		if (options.allow_update)
+			mBuildFlags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+
+		if (options.allow_compaction)
+			mBuildFlags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction;
 
 		auto build_sizes = gContext->device.getAccelerationStructureBuildSizesKHR(
-			vk::AccelerationStructureBuildTypeKHR::eDevice, build_geometry_info, { 1 });
+			vk::AccelerationStructureBuildTypeKHR::eDevice, getBuildGeometryInfo(), { mPrimitiveCount });
 
 		std::tie(mBlasBuffer, mBlasMemory) = CreateBuffer(build_sizes.accelerationStructureSize,
 			vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR);
 
+		mMemorySize = mBlasBuffer.getMemoryRequirements().size;
+		AddMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
+
 		auto create_info = vk::AccelerationStructureCreateInfoKHR()
 			.setBuffer(*mBlasBuffer)
 			.setType(vk::AccelerationStructureTypeKHR::eBottomLevel)
 			.setSize(build_sizes.accelerationStructureSize);
 
 		mBlas = gContext->device.createAccelerationStructureKHR(create_info);
-
-		auto [scratch_buffer, scratch_memory] = CreateBuffer(build_sizes.buildScratchSize,
-			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
-
-		auto scratch_buffer_addr = GetBufferDeviceAddress(*scratch_buffer);
-
-		build_geometry_info
-			.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
-			.setDstAccelerationStructure(*mBlas)
-			.setScratchData(scratch_buffer_addr);
-
-		auto build_range_info = vk::AccelerationStructureBuildRangeInfoKHR()
-			.setPrimitiveCount(static_cast<uint32_t>(index_count / 3));
-
-		auto build_geometry_infos = { build_geometry_info };
-		std::vector build_range_infos = { &build_range_info };
-
-		OneTimeSubmit([&](auto& cmdbuf) {
-			cmdbuf.buildAccelerationStructuresKHR(build_geometry_infos, build_range_infos);
-		});
-	}
-
-	~BottomLevelAccelerationStructureVK()
-	{
-		DestroyStaging(std::move(mBlas));
-		DestroyStaging(std::move(mBlasBuffer));
-		DestroyStaging(std::move(mBlasMemory));
+		mBuildScratchSize = build_sizes.buildScratchSize;
 	}
 };
 
-class TopLevelAccelerationStructureVK : public ObjectVK
+class TopLevelAccelerationStructureVK
 {
 public:
 	const auto& getTlas() const { return mTlas; }
@@ -929,43 +2308,123 @@ private:
 	vk::raii::AccelerationStructureKHR mTlas = nullptr;
 	vk::raii::Buffer mTlasBuffer = nullptr;
 	vk::raii::DeviceMemory mTlasMemory = nullptr;
+	vk::raii::Buffer mInstanceBuffer = nullptr;
+	vk::raii::DeviceMemory mInstanceMemory = nullptr;
+	vk::raii::Buffer mScratchBuffer = nullptr;
+	vk::raii::DeviceMemory mScratchMemory = nullptr;
+	uint32_t mInstanceCount = 0;
+	std::vector<AccelerationStructureInstance> mInstances;
+	vk::DeviceSize mMemorySize = 0;
 
 public:
-	TopLevelAccelerationStructureVK(
-		const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures)
+	TopLevelAccelerationStructureVK(const std::vector<AccelerationStructureInstance>& instances) :
+		mInstanceCount((uint32_t)instances.size())
+	{
+		build(instances, vk::BuildAccelerationStructureModeKHR::eBuild);
+		gContext->all_top_level_acceleration_structures.insert(this);
+	}
+
+	~TopLevelAccelerationStructureVK()
+	{
+		gContext->all_top_level_acceleration_structures.erase(this);
+
+		DestroyStaging(std::move(mTlas));
+		DestroyStaging(std::move(mTlasBuffer));
+		DestroyStaging(std::move(mTlasMemory));
+		DestroyStaging(std::move(mInstanceBuffer));
+		DestroyStaging(std::move(mInstanceMemory));
+		DestroyStaging(std::move(mScratchBuffer));
+		DestroyStaging(std::move(mScratchMemory));
+
+		RemoveMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
+	}
+
+	void update(const std::vector<AccelerationStructureInstance>& instances)
+	{
+		assert(instances.size() == mInstanceCount);
+		build(instances, vk::BuildAccelerationStructureModeKHR::eUpdate);
+	}
+
+	bool references(const std::unordered_set<BottomLevelAccelerationStructureHandle*>& blases) const
+	{
+		return std::ranges::any_of(mInstances, [&](const auto& instance) {
+			return blases.contains(instance.blas);
+		});
+	}
+
+	// compaction moves bottom level structures, the refit picks up their new addresses
+	void refit()
+	{
+		// instances of destroyed bottom level structures have nothing to point at,
+		// such a structure keeps its old addresses until it is updated
+		auto has_destroyed_instances = std::ranges::any_of(mInstances, [](const auto& instance) {
+			return gContext->bottom_level_acceleration_structure_pool.tryGet(instance.blas) == nullptr;
+		});
+
+		if (has_destroyed_instances)
+			return;
+
+		build(mInstances, vk::BuildAccelerationStructureModeKHR::eUpdate);
+	}
+
+private:
+	void build(const std::vector<AccelerationStructureInstance>& instances, vk::BuildAccelerationStructureModeKHR mode)
 	{
-		auto transform = glm::mat4(1.0f);
+		BuildPendingBottomLevelAccelerationStructures();
+
+		mInstances = instances;
 
-		std::vector<vk::AccelerationStructureInstanceKHR> instances;
+		std::vector<vk::AccelerationStructureInstanceKHR> vk_instances;
 
-		for (auto [custom_index, handle] : bottom_level_acceleration_structures)
+		for (const auto& instance : instances)
 		{
-			const auto& blas = *(BottomLevelAccelerationStructureVK*)handle;
+			const auto& blas = *gContext->bottom_level_acceleration_structure_pool.get(instance.blas);
 
 			auto blas_device_address_info = vk::AccelerationStructureDeviceAddressInfoKHR()
 				.setAccelerationStructure(*blas.getBlas());
 
 			auto blas_device_address = gContext->device.getAccelerationStructureAddressKHR(blas_device_address_info);
 
-			auto instance = vk::AccelerationStructureInstanceKHR()
+			// vk::TransformMatrixKHR is a row-major 3x4 matrix
+			auto transform = glm::transpose(instance.transform);
+
+			auto vk_instance = vk::AccelerationStructureInstanceKHR()
 				.setTransform(*(vk::TransformMatrixKHR*)&transform)
-				.setMask(0xFF)
-				.setInstanceShaderBindingTableRecordOffset(0)
-				.setInstanceCustomIndex(custom_index) // gl_InstanceCustomIndexEXT
+				.setMask(instance.mask)
+				.setInstanceShaderBindingTableRecordOffset(instance.sbt_offset)
+				.setInstanceCustomIndex(instance.instance_id) // gl_InstanceCustomIndexEXT
 				.setFlags(vk::GeometryInstanceFlagBitsKHR::eTriangleFacingCullDisable)
 				.setAccelerationStructureReference(blas_device_address);
 
-			instances.push_back(instance);
+			vk_instances.push_back(vk_instance);
 		}
 
-		auto instance_buffer_size = sizeof(vk::AccelerationStructureInstanceKHR) * instances.size();
+		auto instance_buffer_size = sizeof(vk::AccelerationStructureInstanceKHR) * vk_instances.size();
 
-		auto [instance_buffer, instance_buffer_memory] = CreateBuffer(instance_buffer_size,
-			vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+		if (mode == vk::BuildAccelerationStructureModeKHR::eBuild)
+		{
+			std::tie(mInstanceBuffer, mInstanceMemory) = CreateBuffer(instance_buffer_size,
+				GetAccelerationStructureBuildInputUsage() | vk::BufferUsageFlagBits::eTransferDst);
+		}
+
+		// instances are copied in from frame upload memory, so a refit never overwrites
+		// the instances an earlier build of this frame has not read yet
+
+		auto [upload_buffer, upload_offset] = WriteToFrameUploadMemory(vk_instances.data(), instance_buffer_size);
+
+		auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+		EnsureRenderPassDeactivated();
+		EnsureMemoryState(vk::PipelineStageFlagBits2::eTransfer);
+		FlushBarriers(cmdbuf);
+
+		auto instance_region = vk::BufferCopy()
+			.setSrcOffset(upload_offset)
+			.setSize(instance_buffer_size);
 
-		WriteToBuffer(instance_buffer_memory, instances.data(), instance_buffer_size);
+		cmdbuf.copyBuffer(upload_buffer, *mInstanceBuffer, { instance_region });
 
-		auto instance_buffer_addr = GetBufferDeviceAddress(*instance_buffer);
+		auto instance_buffer_addr = GetBufferDeviceAddress(*mInstanceBuffer);
 
 		auto geometry_instances = vk::AccelerationStructureGeometryInstancesDataKHR()
 			.setData(instance_buffer_addr);
@@ -980,48 +2439,50 @@ public:
 
 		auto build_geometry_info = vk::AccelerationStructureBuildGeometryInfoKHR()
 			.setType(vk::AccelerationStructureTypeKHR::eTopLevel)
-			.setFlags(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace)
+			.setFlags(vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace |
+				vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate)
 			.setGeometries(geometry);
 
 		auto build_sizes = gContext->device.getAccelerationStructureBuildSizesKHR(
-			vk::AccelerationStructureBuildTypeKHR::eDevice, build_geometry_info, { (uint32_t)instances.size() });
+			vk::AccelerationStructureBuildTypeKHR::eDevice, build_geometry_info, { mInstanceCount });
 
-		std::tie(mTlasBuffer, mTlasMemory) = CreateBuffer(build_sizes.accelerationStructureSize,
-			vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR);
+		if (mode == vk::BuildAccelerationStructureModeKHR::eBuild)
+		{
+			std::tie(mTlasBuffer, mTlasMemory) = CreateBuffer(build_sizes.accelerationStructureSize,
+				vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR);
 
-		auto create_info = vk::AccelerationStructureCreateInfoKHR()
-			.setBuffer(*mTlasBuffer)
-			.setType(vk::AccelerationStructureTypeKHR::eTopLevel)
-			.setSize(build_sizes.accelerationStructureSize);
+			// refits reuse the scratch buffer, so it fits both modes
+			std::tie(mScratchBuffer, mScratchMemory) = CreateBuffer(std::max(build_sizes.buildScratchSize,
+				build_sizes.updateScratchSize), vk::BufferUsageFlagBits::eStorageBuffer |
+				vk::BufferUsageFlagBits::eShaderDeviceAddress);
+
+			mMemorySize = mTlasBuffer.getMemoryRequirements().size + mInstanceBuffer.getMemoryRequirements().size +
+				mScratchBuffer.getMemoryRequirements().size;
+			AddMemoryUsage(gContext->memory_stats.acceleration_structures, mMemorySize);
 
-		mTlas = gContext->device.createAccelerationStructureKHR(create_info);
+			auto create_info = vk::AccelerationStructureCreateInfoKHR()
+				.setBuffer(*mTlasBuffer)
+				.setType(vk::AccelerationStructureTypeKHR::eTopLevel)
+				.setSize(build_sizes.accelerationStructureSize);
 
-		auto [scratch_buffer, scratch_memory] = CreateBuffer(build_sizes.buildScratchSize,
-			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+			mTlas = gContext->device.createAccelerationStructureKHR(create_info);
+		}
+		else
+		{
+			build_geometry_info.setSrcAccelerationStructure(*mTlas);
+		}
 
-		auto scratch_buffer_addr = GetBufferDeviceAddress(*scratch_buffer);
+		auto scratch_buffer_addr = GetBufferDeviceAddress(*mScratchBuffer);
 
 		build_geometry_info
-			.setMode(vk::BuildAccelerationStructureModeKHR::eBuild)
+			.setMode(mode)
 			.setDstAccelerationStructure(*mTlas)
 			.setScratchData(scratch_buffer_addr);
 
 		auto build_range_info = vk::AccelerationStructureBuildRangeInfoKHR()
-			.setPrimitiveCount((uint32_t)instances.size());
-
-		auto build_geometry_infos = { build_geometry_info };
-		std::vector build_range_infos = { &build_range_info };
+			.setPrimitiveCount(mInstanceCount);
 
-		OneTimeSubmit([&](auto& cmdbuf) {
-			cmdbuf.buildAccelerationStructuresKHR(build_geometry_infos, build_range_infos);
-		});
-	}
-
-	~TopLevelAccelerationStructureVK()
-	{
-		DestroyStaging(std::move(mTlas));
-		DestroyStaging(std::move(mTlasBuffer));
-		DestroyStaging(std::move(mTlasMemory));
+		BuildAccelerationStructures({ build_geometry_info }, { build_range_info });
 	}
 };
 
@@ -1036,8 +2497,16 @@ ContextVK::ContextVK() :
 
 ContextVK::~ContextVK()
 {
-	for (auto object : objects)
-		delete object;
+	top_level_acceleration_structure_pool.clear();
+	bottom_level_acceleration_structure_pool.clear();
+	render_target_pool.clear();
+	texture_pool.clear();
+	vertex_buffer_pool.clear();
+	index_buffer_pool.clear();
+	uniform_buffer_pool.clear();
+	storage_buffer_pool.clear();
+	raytracing_shader_pool.clear();
+	shader_pool.clear();
 }
 
 uint32_t ContextVK::getBackbufferWidth()
@@ -1056,39 +2525,176 @@ vk::Format ContextVK::getBackbufferFormat()
 	return !render_targets.empty() ? render_targets.at(0)->getTexture()->getFormat() : PixelFormatMap.at(PixelFormat::RGBA8UNorm); //gContext->surface_format.format;
 }
 
+static std::vector<RenderTargetVK*> GetRenderPassTargets()
+{
+	if (gContext->render_targets.empty())
+		return { gContext->getCurrentBackbuffer().target.get() };
+
+	return gContext->render_targets;
+}
+
+static void EnsureRenderTargetsState()
+{
+	auto targets = GetRenderPassTargets();
+
+	for (auto target : targets)
+	{
+		target->getTexture()->ensureState(vk::ImageLayout::eGeneral);
+	}
+
+	targets.front()->ensureDepthStencilState(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+}
+
 static void BeginRenderPass()
 {
 	assert(!gContext->render_pass_active);
-	gContext->render_pass_active = true;
 
-	auto targets = gContext->render_targets;
+	auto targets = GetRenderPassTargets();
+
+	auto clear_color = std::exchange(gContext->clear_color, std::nullopt);
+	auto clear_depth = std::exchange(gContext->clear_depth, std::nullopt);
+	auto clear_stencil = std::exchange(gContext->clear_stencil, std::nullopt);
+
+	// no-op when the draw has already moved the targets into their attachment layouts
+	EnsureRenderTargetsState();
 
-	if (targets.empty())
-		targets = { gContext->getCurrentFrame().swapchain_target.get() };
+	auto get_load_op = [](bool clear) {
+		return clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eLoad;
+	};
 
 	std::vector<vk::RenderingAttachmentInfo> color_attachments;
-	std::optional<vk::RenderingAttachmentInfo> depth_stencil_attachment;
+	std::optional<vk::RenderingAttachmentInfo> depth_attachment;
+	std::optional<vk::RenderingAttachmentInfo> stencil_attachment;
 
 	for (auto target : targets)
 	{
+		auto clear_color_value = vk::ClearColorValue();
+
+		if (clear_color.has_value())
+		{
+			auto value = clear_color.value();
+			clear_color_value.setFloat32({ value.r, value.g, value.b, value.a });
+		}
+
 		auto color_attachment = vk::RenderingAttachmentInfo()
 			.setImageView(*target->getTexture()->getImageView())
 			.setImageLayout(vk::ImageLayout::eGeneral)
-			.setLoadOp(vk::AttachmentLoadOp::eLoad)
-			.setStoreOp(vk::AttachmentStoreOp::eStore);
+			.setLoadOp(get_load_op(clear_color.has_value()))
+			.setStoreOp(vk::AttachmentStoreOp::eStore)
+			.setClearValue(vk::ClearValue().setColor(clear_color_value));
 
 		color_attachments.push_back(color_attachment);
 
-		if (!depth_stencil_attachment.has_value())
+		if (!depth_attachment.has_value())
+		{
+			auto clear_depth_stencil_value = vk::ClearDepthStencilValue()
+				.setDepth(clear_depth.value_or(1.0f))
+				.setStencil((uint32_t)clear_stencil.value_or(0));
+
+			auto attachment = vk::RenderingAttachmentInfo()
+				.setImageView(*target->getDepthStencilView())
+				.setImageLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+				.setStoreOp(vk::AttachmentStoreOp::eStore)
+				.setClearValue(vk::ClearValue().setDepthStencil(clear_depth_stencil_value));
+
+			depth_attachment = attachment;
+			depth_attachment->setLoadOp(get_load_op(clear_depth.has_value()));
+
+			stencil_attachment = attachment;
+			stencil_attachment->setLoadOp(get_load_op(clear_stencil.has_value()));
+		}
+	}
+
+	auto width = gContext->getBackbufferWidth();
+	auto height = gContext->getBackbufferHeight();
+
+	auto rendering_info = vk::RenderingInfo()
+		.setRenderArea({ { 0, 0 }, { width, height } })
+		.setLayerCount(1)
+		.setColorAttachments(color_attachments);
+
+	if (depth_attachment.has_value())
+		rendering_info.setPDepthAttachment(&depth_attachment.value());
+
+	if (stencil_attachment.has_value())
+		rendering_info.setPStencilAttachment(&stencil_attachment.value());
+
+	FlushBarriers(gContext->getCurrentFrame().command_buffer);
+
+	gContext->render_pass_active = true;
+	gContext->getCurrentFrame().command_buffer.beginRendering(rendering_info);
+}
+
+static void ResolveFrameUploads()
+{
+	if (gContext->buffers_with_frame_uploads.empty())
+		return;
+
+	for (auto buffer : gContext->buffers_with_frame_uploads)
+	{
+		buffer->resolveFrameUpload();
+	}
+
+	gContext->buffers_with_frame_uploads.clear();
+
+	gContext->vertex_buffers_dirty = true;
+	gContext->index_buffer_dirty = true;
+	gContext->graphics_descriptors_dirty = true;
+}
+
+static void EndRenderPass()
+{
+	assert(gContext->render_pass_active);
+	gContext->render_pass_active = false;
+
+	gContext->getCurrentFrame().command_buffer.endRendering();
+
+	ResolveFrameUploads();
+}
+
+static void ApplyStoreActions()
+{
+	assert(!gContext->render_pass_active);
+
+	auto discard_color = std::exchange(gContext->color_store_op, vk::AttachmentStoreOp::eStore) == vk::AttachmentStoreOp::eDontCare;
+	auto discard_depth_stencil = std::exchange(gContext->depth_stencil_store_op, vk::AttachmentStoreOp::eStore) == vk::AttachmentStoreOp::eDontCare;
+
+	if (!discard_color && !discard_depth_stencil)
+		return;
+
+	// store ops are fixed when rendering begins and any later barrier may still split the pass,
+	// so passes always store and the discard is an empty pass that neither loads nor stores
+
+	auto targets = GetRenderPassTargets();
+
+	EnsureRenderTargetsState();
+
+	std::vector<vk::RenderingAttachmentInfo> color_attachments;
+	std::optional<vk::RenderingAttachmentInfo> depth_stencil_attachment;
+
+	if (discard_color)
+	{
+		for (auto target : targets)
 		{
-			depth_stencil_attachment = vk::RenderingAttachmentInfo()
-				.setImageView(*target->getDepthStencilView())
-				.setImageLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
-				.setLoadOp(vk::AttachmentLoadOp::eLoad)
-				.setStoreOp(vk::AttachmentStoreOp::eStore);
+			auto color_attachment = vk::RenderingAttachmentInfo()
+				.setImageView(*target->getTexture()->getImageView())
+				.setImageLayout(vk::ImageLayout::eGeneral)
+				.setLoadOp(vk::AttachmentLoadOp::eDontCare)
+				.setStoreOp(vk::AttachmentStoreOp::eDontCare);
+
+			color_attachments.push_back(color_attachment);
 		}
 	}
 
+	if (discard_depth_stencil)
+	{
+		depth_stencil_attachment = vk::RenderingAttachmentInfo()
+			.setImageView(*targets.front()->getDepthStencilView())
+			.setImageLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal)
+			.setLoadOp(vk::AttachmentLoadOp::eDontCare)
+			.setStoreOp(vk::AttachmentStoreOp::eDontCare);
+	}
+
 	auto width = gContext->getBackbufferWidth();
 	auto height = gContext->getBackbufferHeight();
 
@@ -1103,15 +2709,11 @@ static void BeginRenderPass()
 		rendering_info.setPStencilAttachment(&depth_stencil_attachment.value());
 	}
 
-	gContext->getCurrentFrame().command_buffer.beginRendering(rendering_info);
-}
-
-static void EndRenderPass()
-{
-	assert(gContext->render_pass_active);
-	gContext->render_pass_active = false;
+	auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
 
-	gContext->getCurrentFrame().command_buffer.endRendering();
+	FlushBarriers(cmdbuf);
+	cmdbuf.beginRendering(rendering_info);
+	cmdbuf.endRendering();
 }
 
 static void EnsureRenderPassActivated()
@@ -1122,138 +2724,135 @@ static void EnsureRenderPassActivated()
 	BeginRenderPass();
 }
 
+static bool HasPendingClears()
+{
+	return gContext->clear_color.has_value() || gContext->clear_depth.has_value() ||
+		gContext->clear_stencil.has_value();
+}
+
 static void EnsureRenderPassDeactivated()
 {
+	// pending clears must reach the targets before they are used outside of a render pass
+	if (!gContext->render_pass_active && HasPendingClears())
+		BeginRenderPass();
+
 	if (!gContext->render_pass_active)
 		return;
 
 	EndRenderPass();
 }
 
-static void SetImageMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Image image, vk::ImageAspectFlags aspect_mask,
-	vk::ImageLayout old_layout, vk::ImageLayout new_layout, uint32_t base_mip_level, uint32_t level_count,
-	uint32_t base_array_layer, uint32_t layer_count)
+static std::tuple<vk::PipelineStageFlags2, vk::AccessFlags2> GetImageLayoutSrcAccess(vk::ImageLayout layout)
 {
-	assert(new_layout != vk::ImageLayout::eUndefined && new_layout != vk::ImageLayout::ePreinitialized);
-
-	constexpr vk::PipelineStageFlags depth_stage_mask = vk::PipelineStageFlagBits::eEarlyFragmentTests |
-		vk::PipelineStageFlagBits::eLateFragmentTests;
-
-	constexpr vk::PipelineStageFlags sampled_stage_mask = vk::PipelineStageFlagBits::eVertexShader |
-		vk::PipelineStageFlagBits::eFragmentShader;
+	// only writes need to be made available, reads just have to be finished before the transition
 
-	vk::PipelineStageFlags src_stage_mask = vk::PipelineStageFlagBits::eTopOfPipe;
-	vk::PipelineStageFlags dst_stage_mask = vk::PipelineStageFlagBits::eBottomOfPipe;
+	constexpr vk::PipelineStageFlags2 depth_stage_mask = vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+		vk::PipelineStageFlagBits2::eLateFragmentTests;
 
-	vk::AccessFlags src_access_mask;
-	vk::AccessFlags dst_access_mask;
+	constexpr vk::PipelineStageFlags2 sampled_stage_mask = vk::PipelineStageFlagBits2::eVertexShader |
+		vk::PipelineStageFlagBits2::eFragmentShader;
 
-	switch (old_layout)
+	switch (layout)
 	{
 	case vk::ImageLayout::eUndefined:
-		break;
+		return { vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
 
 	case vk::ImageLayout::eGeneral:
-		src_stage_mask = vk::PipelineStageFlagBits::eAllCommands;
-		src_access_mask = vk::AccessFlagBits::eMemoryWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryWrite };
 
 	case vk::ImageLayout::eColorAttachmentOptimal:
-		src_stage_mask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-		src_access_mask = vk::AccessFlagBits::eColorAttachmentWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite };
 
 	case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-		src_stage_mask = depth_stage_mask;
-		src_access_mask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-		break;
+		return { depth_stage_mask, vk::AccessFlagBits2::eDepthStencilAttachmentWrite };
 
 	case vk::ImageLayout::eDepthStencilReadOnlyOptimal:
-		src_stage_mask = depth_stage_mask | sampled_stage_mask;
-		break;
+		return { depth_stage_mask | sampled_stage_mask, vk::AccessFlagBits2::eNone };
 
 	case vk::ImageLayout::eShaderReadOnlyOptimal:
-		src_stage_mask = sampled_stage_mask;
-		break;
+		return { sampled_stage_mask, vk::AccessFlagBits2::eNone };
 
 	case vk::ImageLayout::eTransferSrcOptimal:
-		src_stage_mask = vk::PipelineStageFlagBits::eTransfer;
-		break;
+		return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eNone };
 
 	case vk::ImageLayout::eTransferDstOptimal:
-		src_stage_mask = vk::PipelineStageFlagBits::eTransfer;
-		src_access_mask = vk::AccessFlagBits::eTransferWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite };
 
 	case vk::ImageLayout::ePreinitialized:
-		src_stage_mask = vk::PipelineStageFlagBits::eHost;
-		src_access_mask = vk::AccessFlagBits::eHostWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eHost, vk::AccessFlagBits2::eHostWrite };
 
 	case vk::ImageLayout::ePresentSrcKHR:
-		break;
+		return { vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
 
 	default:
 		assert(false);
-		break;
+		return { vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryWrite };
 	}
+}
 
-	switch (new_layout)
+static std::tuple<vk::PipelineStageFlags2, vk::AccessFlags2> GetImageLayoutDstAccess(vk::ImageLayout layout)
+{
+	constexpr vk::PipelineStageFlags2 depth_stage_mask = vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+		vk::PipelineStageFlagBits2::eLateFragmentTests;
+
+	constexpr vk::PipelineStageFlags2 sampled_stage_mask = vk::PipelineStageFlagBits2::eVertexShader |
+		vk::PipelineStageFlagBits2::eFragmentShader;
+
+	switch (layout)
 	{
 	case vk::ImageLayout::eGeneral:
-		dst_stage_mask = vk::PipelineStageFlagBits::eAllCommands;
-		dst_access_mask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite };
 
 	case vk::ImageLayout::eColorAttachmentOptimal:
-		dst_stage_mask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-		dst_access_mask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead |
+			vk::AccessFlagBits2::eColorAttachmentWrite };
 
 	case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-		dst_stage_mask = depth_stage_mask;
-		dst_access_mask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-		break;
+		return { depth_stage_mask, vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+			vk::AccessFlagBits2::eDepthStencilAttachmentWrite };
 
 	case vk::ImageLayout::eDepthStencilReadOnlyOptimal:
-		dst_stage_mask = depth_stage_mask | sampled_stage_mask;
-		dst_access_mask = vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eShaderRead |
-			vk::AccessFlagBits::eInputAttachmentRead;
-		break;
+		return { depth_stage_mask | sampled_stage_mask, vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+			vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eInputAttachmentRead };
 
 	case vk::ImageLayout::eShaderReadOnlyOptimal:
-		dst_stage_mask = sampled_stage_mask;
-		dst_access_mask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eInputAttachmentRead;
-		break;
+		return { sampled_stage_mask, vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eInputAttachmentRead };
 
 	case vk::ImageLayout::eTransferSrcOptimal:
-		dst_stage_mask = vk::PipelineStageFlagBits::eTransfer;
-		dst_access_mask = vk::AccessFlagBits::eTransferRead;
-		break;
+		return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead };
 
 	case vk::ImageLayout::eTransferDstOptimal:
-		dst_stage_mask = vk::PipelineStageFlagBits::eTransfer;
-		dst_access_mask = vk::AccessFlagBits::eTransferWrite;
-		break;
+		return { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite };
 
 	case vk::ImageLayout::ePresentSrcKHR:
 		// vkQueuePresentKHR performs automatic visibility operations
-		break;
+		return { vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone };
 
 	default:
 		assert(false);
-		break;
+		return { vk::PipelineStageFlagBits2::eAllCommands, vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite };
 	}
+}
+
+static void AddImageMemoryBarrier(vk::Image image, vk::ImageAspectFlags aspect_mask, vk::ImageLayout old_layout,
+	vk::ImageLayout new_layout, uint32_t base_mip_level, uint32_t level_count)
+{
+	assert(new_layout != vk::ImageLayout::eUndefined && new_layout != vk::ImageLayout::ePreinitialized);
+
+	auto [src_stage_mask, src_access_mask] = GetImageLayoutSrcAccess(old_layout);
+	auto [dst_stage_mask, dst_access_mask] = GetImageLayoutDstAccess(new_layout);
 
 	auto subresource_range = vk::ImageSubresourceRange()
 		.setAspectMask(aspect_mask)
 		.setBaseMipLevel(base_mip_level)
 		.setLevelCount(level_count)
-		.setBaseArrayLayer(base_array_layer)
-		.setLayerCount(layer_count);
+		.setBaseArrayLayer(0)
+		.setLayerCount(1);
 
-	auto image_memory_barrier = vk::ImageMemoryBarrier()
+	auto image_memory_barrier = vk::ImageMemoryBarrier2()
+		.setSrcStageMask(src_stage_mask)
 		.setSrcAccessMask(src_access_mask)
+		.setDstStageMask(dst_stage_mask)
 		.setDstAccessMask(dst_access_mask)
 		.setOldLayout(old_layout)
 		.setNewLayout(new_layout)
@@ -1262,38 +2861,55 @@ static void SetImageMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Ima
 		.setImage(image)
 		.setSubresourceRange(subresource_range);
 
-	cmdbuf.pipelineBarrier(src_stage_mask, dst_stage_mask, {}, {}, {}, { image_memory_barrier });
+	gContext->pending_image_barriers.push_back(image_memory_barrier);
 }
 
-static void SetImageMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Image image, vk::Format format,
-	vk::ImageLayout old_layout, vk::ImageLayout new_layout, uint32_t base_mip_level, uint32_t level_count,
-	uint32_t base_array_layer, uint32_t layer_count)
+static vk::AccessFlags2 GetStageWriteAccess(vk::PipelineStageFlags2 stage)
 {
-	vk::ImageAspectFlags aspect_mask;
-	if (new_layout == vk::ImageLayout::eDepthStencilAttachmentOptimal)
-	{
-		aspect_mask = vk::ImageAspectFlagBits::eDepth;
-		if (format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint)
-		{
-			aspect_mask |= vk::ImageAspectFlagBits::eStencil;
-		}
-	}
-	else
-	{
-		aspect_mask = vk::ImageAspectFlagBits::eColor;
-	}
-	SetImageMemoryBarrier(cmdbuf, image, aspect_mask, old_layout, new_layout, base_mip_level, level_count,
-		base_array_layer, layer_count);
+	if (stage == vk::PipelineStageFlagBits2::eTransfer)
+		return vk::AccessFlagBits2::eTransferWrite;
+
+	if (stage == vk::PipelineStageFlagBits2::eComputeShader || stage == vk::PipelineStageFlagBits2::eRayTracingShaderKHR)
+		return vk::AccessFlagBits2::eShaderStorageWrite;
+
+	if (stage == vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+		return vk::AccessFlagBits2::eAccelerationStructureWriteKHR;
+
+	return vk::AccessFlagBits2::eMemoryWrite;
 }
 
-static void SetMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::PipelineStageFlags2 src_stage,
-	vk::PipelineStageFlags2 dst_stage)
+static vk::AccessFlags2 GetStageAccess(vk::PipelineStageFlags2 stage)
+{
+	if (stage == vk::PipelineStageFlagBits2::eTransfer)
+		return vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite;
+
+	if (stage == vk::PipelineStageFlagBits2::eComputeShader)
+		return vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite;
+
+	if (stage == vk::PipelineStageFlagBits2::eRayTracingShaderKHR)
+		return vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite |
+			vk::AccessFlagBits2::eAccelerationStructureReadKHR;
+
+	if (stage == vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR)
+		return vk::AccessFlagBits2::eAccelerationStructureReadKHR | vk::AccessFlagBits2::eAccelerationStructureWriteKHR |
+			vk::AccessFlagBits2::eShaderRead;
+
+	return vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite;
+}
+
+static vk::MemoryBarrier2 MakeMemoryBarrier(vk::PipelineStageFlags2 src_stage, vk::PipelineStageFlags2 dst_stage)
 {
-	auto memory_barrier = vk::MemoryBarrier2()
+	return vk::MemoryBarrier2()
 		.setSrcStageMask(src_stage)
-		.setSrcAccessMask(vk::AccessFlagBits2::eMemoryWrite)
+		.setSrcAccessMask(GetStageWriteAccess(src_stage))
 		.setDstStageMask(dst_stage)
-		.setDstAccessMask(vk::AccessFlagBits2::eMemoryWrite | vk::AccessFlagBits2::eMemoryRead);
+		.setDstAccessMask(GetStageAccess(dst_stage));
+}
+
+static void SetMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::PipelineStageFlags2 src_stage,
+	vk::PipelineStageFlags2 dst_stage)
+{
+	auto memory_barrier = MakeMemoryBarrier(src_stage, dst_stage);
 
 	auto dependency_info = vk::DependencyInfo()
 		.setMemoryBarriers(memory_barrier);
@@ -1301,39 +2917,246 @@ static void SetMemoryBarrier(const vk::raii::CommandBuffer& cmdbuf, vk::Pipeline
 	cmdbuf.pipelineBarrier2(dependency_info);
 }
 
-static void EnsureMemoryState(const vk::raii::CommandBuffer& cmdbuf, vk::PipelineStageFlags2 stage)
+static void EnsureMemoryState(vk::PipelineStageFlags2 stage)
 {
 	if (gContext->current_memory_stage == stage)
 		return;
 
-	EnsureRenderPassDeactivated();
-	SetMemoryBarrier(cmdbuf, gContext->current_memory_stage, stage);
+	auto memory_barrier = MakeMemoryBarrier(gContext->current_memory_stage, stage);
+
+	if (gContext->pending_memory_barrier.has_value())
+	{
+		auto& pending_barrier = gContext->pending_memory_barrier.value();
+		pending_barrier.srcStageMask |= memory_barrier.srcStageMask;
+		pending_barrier.srcAccessMask |= memory_barrier.srcAccessMask;
+		pending_barrier.dstStageMask |= memory_barrier.dstStageMask;
+		pending_barrier.dstAccessMask |= memory_barrier.dstAccessMask;
+	}
+	else
+	{
+		gContext->pending_memory_barrier = memory_barrier;
+	}
 
 	gContext->current_memory_stage = stage;
 }
 
-static void OneTimeSubmit(std::function<void(const vk::raii::CommandBuffer&)> func)
+static bool HasPendingBarriers()
 {
-	auto command_buffer_allocate_info = vk::CommandBufferAllocateInfo()
-		.setCommandBufferCount(1)
-		.setCommandPool(*gContext->command_pool)
-		.setLevel(vk::CommandBufferLevel::ePrimary);
+	return !gContext->pending_image_barriers.empty() || gContext->pending_memory_barrier.has_value();
+}
 
-	auto command_buffers = gContext->device.allocateCommandBuffers(command_buffer_allocate_info);
-	auto cmdbuf = std::move(command_buffers.at(0));
+static void FlushBarriers(const vk::raii::CommandBuffer& cmdbuf)
+{
+	// everything queued by EnsureMemoryState and the layout tracking goes into a single barrier
 
-	auto command_buffer_begin_info = vk::CommandBufferBeginInfo()
-		.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+	if (!HasPendingBarriers())
+		return;
 
-	cmdbuf.begin(command_buffer_begin_info);
-	func(cmdbuf);
-	cmdbuf.end();
-	
-	auto submit_info = vk::SubmitInfo()
-		.setCommandBuffers(*cmdbuf);
+	assert(!gContext->render_pass_active);
 
-	gContext->queue.submit(submit_info);
-	gContext->queue.waitIdle();
+	auto dependency_info = vk::DependencyInfo()
+		.setImageMemoryBarriers(gContext->pending_image_barriers);
+
+	if (gContext->pending_memory_barrier.has_value())
+		dependency_info.setMemoryBarriers(gContext->pending_memory_barrier.value());
+
+	cmdbuf.pipelineBarrier2(dependency_info);
+
+	gContext->pending_image_barriers.clear();
+	gContext->pending_memory_barrier.reset();
+}
+
+static void BuildAccelerationStructures(const std::vector<vk::AccelerationStructureBuildGeometryInfoKHR>& build_geometry_infos,
+	const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& build_range_infos)
+{
+	auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+	EnsureRenderPassDeactivated();
+	EnsureMemoryState(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR);
+	FlushBarriers(cmdbuf);
+
+	std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> build_range_info_ptrs;
+
+	for (const auto& build_range_info : build_range_infos)
+	{
+		build_range_info_ptrs.push_back(&build_range_info);
+	}
+
+	cmdbuf.buildAccelerationStructuresKHR(build_geometry_infos, build_range_info_ptrs);
+
+	// next builds can read this structure (blas -> tlas), as can the rays
+	SetMemoryBarrier(cmdbuf, vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR,
+		vk::PipelineStageFlagBits2::eAllCommands);
+}
+
+static void BuildPendingBottomLevelAccelerationStructures()
+{
+	if (gContext->pending_bottom_level_acceleration_structures.empty())
+		return;
+
+	auto handles = std::exchange(gContext->pending_bottom_level_acceleration_structures, {});
+
+	std::vector<BottomLevelAccelerationStructureVK*> blases;
+
+	for (auto handle : handles)
+	{
+		blases.push_back(gContext->bottom_level_acceleration_structure_pool.get(handle));
+	}
+
+	auto acceleration_structure_properties = gContext->physical_device.getProperties2<vk::PhysicalDeviceProperties2,
+		vk::PhysicalDeviceAccelerationStructurePropertiesKHR>().get<vk::PhysicalDeviceAccelerationStructurePropertiesKHR>();
+
+	auto scratch_alignment = acceleration_structure_properties.minAccelerationStructureScratchOffsetAlignment;
+
+	// all builds of the batch share one scratch buffer and run without barriers between each other
+
+	std::vector<vk::DeviceSize> scratch_offsets;
+	vk::DeviceSize scratch_size = 0;
+
+	for (auto blas : blases)
+	{
+		scratch_offsets.push_back(scratch_size);
+		scratch_size += AlignUp(blas->getBuildScratchSize(), scratch_alignment);
+	}
+
+	auto [scratch_buffer, scratch_memory] = CreateBuffer(scratch_size + scratch_alignment,
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+
+	auto scratch_buffer_addr = AlignUp(GetBufferDeviceAddress(*scratch_buffer), scratch_alignment);
+
+	std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> build_geometry_infos;
+	std::vector<vk::AccelerationStructureBuildRangeInfoKHR> build_range_infos;
+
+	for (size_t i = 0; i < blases.size(); i++)
+	{
+		auto blas = blases.at(i);
+
+		auto build_geometry_info = blas->getBuildGeometryInfo()
+			.setScratchData(scratch_buffer_addr + scratch_offsets.at(i));
+
+		build_geometry_infos.push_back(build_geometry_info);
+		build_range_infos.push_back(blas->getBuildRangeInfo());
+	}
+
+	BuildAccelerationStructures(build_geometry_infos, build_range_infos);
+
+	DestroyStaging(std::move(scratch_buffer));
+	DestroyStaging(std::move(scratch_memory));
+
+	std::vector<BottomLevelAccelerationStructureHandle*> compactable_blases;
+
+	for (size_t i = 0; i < blases.size(); i++)
+	{
+		auto blas = blases.at(i);
+		blas->releaseBuildInputs();
+
+		if (blas->isCompactionAllowed())
+			compactable_blases.push_back(handles.at(i));
+	}
+
+	if (compactable_blases.empty())
+		return;
+
+	auto query_count = (uint32_t)compactable_blases.size();
+
+	auto query_pool_create_info = vk::QueryPoolCreateInfo()
+		.setQueryType(vk::QueryType::eAccelerationStructureCompactedSizeKHR)
+		.setQueryCount(query_count);
+
+	auto query_pool = gContext->device.createQueryPool(query_pool_create_info);
+
+	std::vector<vk::AccelerationStructureKHR> acceleration_structures;
+
+	for (auto handle : compactable_blases)
+	{
+		acceleration_structures.push_back(*gContext->bottom_level_acceleration_structure_pool.get(handle)->getBlas());
+	}
+
+	auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+	cmdbuf.resetQueryPool(*query_pool, 0, query_count);
+	cmdbuf.writeAccelerationStructuresPropertiesKHR(acceleration_structures,
+		vk::QueryType::eAccelerationStructureCompactedSizeKHR, *query_pool, 0);
+
+	// the commands being recorded now will signal the next timeline value
+
+	gContext->blas_compactions.push_back({
+		.query_pool = std::move(query_pool),
+		.blases = std::move(compactable_blases),
+		.timeline_value = gContext->submitted_timeline_value + 1
+	});
+}
+
+static void CompactBottomLevelAccelerationStructures()
+{
+	if (gContext->blas_compactions.empty())
+		return;
+
+	auto completed_value = gContext->timeline_semaphore.getCounterValue();
+	auto& cmdbuf = gContext->getCurrentFrame().command_buffer;
+
+	std::unordered_set<BottomLevelAccelerationStructureHandle*> compacted_blases;
+
+	std::erase_if(gContext->blas_compactions, [&](const ContextVK::BlasCompaction& compaction) {
+		if (compaction.timeline_value > completed_value)
+			return false;
+
+		auto query_count = (uint32_t)compaction.blases.size();
+
+		auto [result, compacted_sizes] = compaction.query_pool.getResults<vk::DeviceSize>(0, query_count,
+			query_count * sizeof(vk::DeviceSize), sizeof(vk::DeviceSize), vk::QueryResultFlagBits::e64);
+
+		if (result != vk::Result::eSuccess)
+			return false;
+
+		if (compacted_blases.empty())
+		{
+			EnsureRenderPassDeactivated();
+			EnsureMemoryState(vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR);
+			FlushBarriers(cmdbuf);
+		}
+
+		for (size_t i = 0; i < compaction.blases.size(); i++)
+		{
+			auto handle = compaction.blases.at(i);
+			auto blas = gContext->bottom_level_acceleration_structure_pool.tryGet(handle);
+
+			if (blas == nullptr)
+				continue;
+
+			blas->compact(cmdbuf, compacted_sizes.at(i));
+			compacted_blases.insert(handle);
+		}
+
+		return true;
+	});
+
+	if (compacted_blases.empty())
+		return;
+
+	SetMemoryBarrier(cmdbuf, vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR,
+		vk::PipelineStageFlagBits2::eAllCommands);
+
+	// top level structures built before the compaction still point at the old copies
+
+	for (auto tlas : gContext->all_top_level_acceleration_structures)
+	{
+		if (tlas->references(compacted_blases))
+			tlas->refit();
+	}
+}
+
+static void BuildPendingBottomLevelAccelerationStructuresReading(const BufferVK* buffer)
+{
+	// a destroyed buffer stays alive until the commands recorded now are finished,
+	// so only builds that read it have to be recorded before it goes
+
+	auto reads_buffer = std::ranges::any_of(gContext->pending_bottom_level_acceleration_structures, [&](auto handle) {
+		return gContext->bottom_level_acceleration_structure_pool.get(handle)->readsBuffer(buffer);
+	});
+
+	if (reads_buffer)
+		BuildPendingBottomLevelAccelerationStructures();
 }
 
 static vk::raii::Sampler CreateSamplerState(const SamplerStateVK& sampler_state)
@@ -1372,236 +3195,177 @@ static vk::raii::Sampler CreateSamplerState(const SamplerStateVK& sampler_state)
 	return gContext->device.createSampler(sampler_create_info);
 }
 
-static void PushDescriptorBuffer(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding, vk::DescriptorType type,
-	const vk::raii::Buffer& buffer)
-{
-	auto descriptor_buffer_info = vk::DescriptorBufferInfo()
-		.setBuffer(*buffer)
-		.setRange(VK_WHOLE_SIZE);
-
-	auto write_descriptor_set = vk::WriteDescriptorSet()
-		.setDstBinding(binding)
-		.setDescriptorCount(1)
-		.setDescriptorType(type)
-		.setBufferInfo(descriptor_buffer_info);
-
-	cmdlist.pushDescriptorSetKHR(pipeline_bind_point,
-		*pipeline_layout, 0, write_descriptor_set);
-}
-
-static void PushDescriptorTexture(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)
-{
-	if (!gContext->sampler_states.contains(gContext->sampler_state))
-	{
-		auto sampler = CreateSamplerState(gContext->sampler_state);
-		gContext->sampler_states.insert({ gContext->sampler_state, std::move(sampler) });
-	}
-
-	auto texture = gContext->textures.at(binding);
-	texture->ensureState(cmdlist, vk::ImageLayout::eGeneral);
-
-	const auto& sampler = gContext->sampler_states.at(gContext->sampler_state);
-
-	auto descriptor_image_info = vk::DescriptorImageInfo()
-		.setSampler(*sampler)
-		.setImageView(*texture->getImageView())
-		.setImageLayout(vk::ImageLayout::eGeneral);
-
-	auto write_descriptor_set = vk::WriteDescriptorSet()
-		.setDstBinding(binding)
-		.setDescriptorCount(1)
-		.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
-		.setImageInfo(descriptor_image_info);
-
-	cmdlist.pushDescriptorSetKHR(pipeline_bind_point,
-		*pipeline_layout, 0, write_descriptor_set);
-}
-
-static void PushDescriptorUniformBuffer(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)
-{
-	auto buffer = gContext->uniform_buffers.at(binding);
-
-	PushDescriptorBuffer(cmdlist, pipeline_bind_point, pipeline_layout, binding,
-		vk::DescriptorType::eUniformBuffer, buffer->getBuffer());
-}
-
-static void PushDescriptorAccelerationStructure(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)
-{
-	auto acceleration_structure = gContext->top_level_acceleration_structures.at(binding);
-
-	auto write_descriptor_set_acceleration_structure = vk::WriteDescriptorSetAccelerationStructureKHR()
-		.setAccelerationStructures(*acceleration_structure->getTlas());
-
-	auto write_descriptor_set = vk::WriteDescriptorSet()
-		.setDstBinding(binding)
-		.setDescriptorCount(1)
-		.setDescriptorType(vk::DescriptorType::eAccelerationStructureKHR)
-		.setPNext(&write_descriptor_set_acceleration_structure);
-
-	cmdlist.pushDescriptorSetKHR(pipeline_bind_point,
-		*pipeline_layout, 0, write_descriptor_set);
-}
-
-static void PushDescriptorStorageImage(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)
+static vk::Sampler GetCurrentSampler()
 {
-	auto texture = gContext->render_targets.at(0)->getTexture();
-	texture->ensureState(cmdlist, vk::ImageLayout::eGeneral);
-
-	auto descriptor_image_info = vk::DescriptorImageInfo()
-		.setImageLayout(vk::ImageLayout::eGeneral)
-		.setImageView(*texture->getImageView());
+	auto it = gContext->sampler_states.find(gContext->sampler_state);
 
-	auto write_descriptor_set = vk::WriteDescriptorSet()
-		.setDstBinding(binding)
-		.setDescriptorCount(1)
-		.setDescriptorType(vk::DescriptorType::eStorageImage)
-		.setImageInfo(descriptor_image_info);
+	if (it == gContext->sampler_states.end())
+		it = gContext->sampler_states.emplace(gContext->sampler_state, CreateSamplerState(gContext->sampler_state)).first;
 
-	cmdlist.pushDescriptorSetKHR(pipeline_bind_point,
-		*pipeline_layout, 0, write_descriptor_set);
+	return *it->second;
 }
 
-static void PushDescriptorStorageBuffer(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)
+static void PushDescriptors(vk::raii::CommandBuffer& cmdlist, const vk::raii::PipelineLayout& pipeline_layout,
+	const vk::raii::DescriptorUpdateTemplate& descriptor_update_template,
+	const std::vector<vk::DescriptorSetLayoutBinding>& required_descriptor_bindings)
 {
-	auto buffer = gContext->storage_buffers.at(binding);
-
-	PushDescriptorBuffer(cmdlist, pipeline_bind_point, pipeline_layout, binding,
-		vk::DescriptorType::eStorageBuffer, buffer->getBuffer());
-}
+	if (required_descriptor_bindings.empty())
+		return;
 
-static void PushDescriptors(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-	const vk::raii::PipelineLayout& pipeline_layout, const std::vector<vk::DescriptorSetLayoutBinding>& required_descriptor_bindings,
-	const std::unordered_set<uint32_t>& ignore_bindings = {})
-{
-	using PushTypedCallback = std::function<void(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
-		const vk::raii::PipelineLayout& pipeline_layout, uint32_t binding)>;
+	auto& descriptor_data = gContext->descriptor_data;
+	descriptor_data.resize(required_descriptor_bindings.size());
 
-	static const std::unordered_map<vk::DescriptorType, PushTypedCallback> PushTypedCallbacks = {
-		{ vk::DescriptorType::eCombinedImageSampler, PushDescriptorTexture },
-		{ vk::DescriptorType::eUniformBuffer, PushDescriptorUniformBuffer },
-		{ vk::DescriptorType::eAccelerationStructureKHR, PushDescriptorAccelerationStructure },
-		{ vk::DescriptorType::eStorageImage, PushDescriptorStorageImage },
-		{ vk::DescriptorType::eStorageBuffer, PushDescriptorStorageBuffer },
-	};
+	vk::Sampler sampler = nullptr;
 
-	for (const auto& required_descriptor_binding : required_descriptor_bindings)
+	for (size_t i = 0; i < required_descriptor_bindings.size(); i++)
 	{
-		auto binding = required_descriptor_binding.binding;
+		auto binding = required_descriptor_bindings.at(i).binding;
+		auto type = required_descriptor_bindings.at(i).descriptorType;
+		auto& data = descriptor_data.at(i);
 
-		if (ignore_bindings.contains(binding))
-			continue;
+		if (type == vk::DescriptorType::eCombinedImageSampler)
+		{
+			if (!sampler)
+				sampler = GetCurrentSampler();
 
-		auto type = required_descriptor_binding.descriptorType;
-		const auto& callback = PushTypedCallbacks.at(type);
-		callback(cmdlist, pipeline_bind_point, pipeline_layout, binding);
-	}
-}
+			auto texture = gContext->textures.at(binding);
+			texture->ensureState(vk::ImageLayout::eGeneral);
 
-template<typename T>
-inline T AlignUp(T size, size_t alignment) noexcept
-{
-	if (alignment > 0)
-	{
-		assert(((alignment - 1) & alignment) == 0);
-		auto mask = static_cast<T>(alignment - 1);
-		return (size + mask) & ~mask;
-	}
-	return size;
-}
+			data.image = vk::DescriptorImageInfo()
+				.setSampler(sampler)
+				.setImageView(*texture->getImageView())
+				.setImageLayout(vk::ImageLayout::eGeneral);
+		}
+		else if (type == vk::DescriptorType::eUniformBuffer)
+		{
+			gContext->uniform_buffers.at(binding)->ensureUploadCompleted();
 
-struct RaytracingShaderBindingTable
-{
-	vk::raii::Buffer raygen_buffer;
-	vk::raii::DeviceMemory raygen_memory;
-	vk::StridedDeviceAddressRegionKHR raygen_address;
+			data.buffer = vk::DescriptorBufferInfo()
+				.setBuffer(gContext->uniform_buffers.at(binding)->getBindBuffer())
+				.setOffset(gContext->uniform_buffers.at(binding)->getBindOffset())
+				.setRange(gContext->uniform_buffers.at(binding)->getBindRange());
+		}
+		else if (type == vk::DescriptorType::eStorageBuffer)
+		{
+			gContext->storage_buffers.at(binding)->ensureUploadCompleted();
 
-	vk::raii::Buffer miss_buffer;
-	vk::raii::DeviceMemory miss_memory;
-	vk::StridedDeviceAddressRegionKHR miss_address;
+			data.buffer = vk::DescriptorBufferInfo()
+				.setBuffer(gContext->storage_buffers.at(binding)->getBindBuffer())
+				.setOffset(gContext->storage_buffers.at(binding)->getBindOffset())
+				.setRange(gContext->storage_buffers.at(binding)->getBindRange());
+		}
+		else if (type == vk::DescriptorType::eStorageImage)
+		{
+			auto texture = gContext->render_targets.at(0)->getTexture();
+			texture->ensureState(vk::ImageLayout::eGeneral);
 
-	vk::raii::Buffer hit_buffer;
-	vk::raii::DeviceMemory hit_memory;
-	vk::StridedDeviceAddressRegionKHR hit_address;
+			data.image = vk::DescriptorImageInfo()
+				.setImageView(*texture->getImageView())
+				.setImageLayout(vk::ImageLayout::eGeneral);
+		}
+		else if (type == vk::DescriptorType::eAccelerationStructureKHR)
+		{
+			data.acceleration_structure = static_cast<VkAccelerationStructureKHR>(
+				*gContext->top_level_acceleration_structures.at(binding)->getTlas());
+		}
+		else
+		{
+			assert(false);
+		}
+	}
 
-	vk::StridedDeviceAddressRegionKHR callable_address;
-};
+	cmdlist.pushDescriptorSetWithTemplateKHR(*descriptor_update_template, *pipeline_layout, 0, descriptor_data.front());
+}
 
-static RaytracingShaderBindingTable CreateRaytracingShaderBindingTable(const vk::raii::Pipeline& pipeline)
+static RaytracingShaderBindingTable CreateRaytracingShaderBindingTable(const RaytracingPipelineStateVK& pipeline_state,
+	const vk::raii::Pipeline& pipeline)
 {
 	auto ray_tracing_pipeline_properties = gContext->physical_device.getProperties2<vk::PhysicalDeviceProperties2,
 		vk::PhysicalDeviceRayTracingPipelinePropertiesKHR>().get<vk::PhysicalDeviceRayTracingPipelinePropertiesKHR>();
 
 	auto handle_size = ray_tracing_pipeline_properties.shaderGroupHandleSize;
 	auto handle_size_aligned = AlignUp(handle_size, ray_tracing_pipeline_properties.shaderGroupHandleAlignment);
+	auto base_alignment = ray_tracing_pipeline_properties.shaderGroupBaseAlignment;
 
-	auto [raygen_buffer, raygen_memory] = CreateBuffer(handle_size_aligned,
-		vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+	const auto& shader = pipeline_state.shader;
 
-	auto [miss_buffer, miss_memory] = CreateBuffer(handle_size_aligned, 
-		vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+	auto raygen_shader_count = (uint32_t)1;
+	auto miss_shader_count = (uint32_t)shader->getMissShaderModules().size();
+	auto hit_shader_count = (uint32_t)shader->getClosestHitShaderModules().size();
 
-	auto [hit_buffer, hit_memory] = CreateBuffer(handle_size_aligned,
-		vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+	auto group_count = raygen_shader_count + miss_shader_count + hit_shader_count;
 
-	const auto& shader = gContext->raytracing_pipeline_state.shader;
+	auto shader_handle_storage = pipeline.getRayTracingShaderGroupHandlesKHR<uint8_t>(0, group_count,
+		group_count * handle_size);
 
-	auto raygen_shader_count = 1;
-	auto miss_shader_count = shader->getMissShaderModules().size();
-	auto hit_shader_count = 1;
+	// every region starts at shaderGroupBaseAlignment, raygen region size must be equal to its stride
 
-	auto group_count = raygen_shader_count + miss_shader_count + hit_shader_count;
-	auto sbt_size = group_count * handle_size_aligned;
+	auto raygen_stride = AlignUp(handle_size_aligned, base_alignment);
+	auto raygen_size = raygen_stride;
+	auto miss_size = AlignUp(miss_shader_count * handle_size_aligned, base_alignment);
+	auto hit_size = AlignUp(hit_shader_count * handle_size_aligned, base_alignment);
+
+	auto raygen_offset = 0u;
+	auto miss_offset = raygen_offset + raygen_size;
+	auto hit_offset = miss_offset + miss_size;
+
+	auto sbt_size = hit_offset + hit_size;
 
-	auto shader_handle_storage = pipeline.getRayTracingShaderGroupHandlesKHR<uint8_t>(0, (uint32_t)group_count, sbt_size);
+	auto [buffer, memory] = CreateBuffer(sbt_size + base_alignment,
+		vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+
+	auto buffer_address = GetBufferDeviceAddress(*buffer);
+	auto base_address = AlignUp(buffer_address, base_alignment);
+	auto base_offset = (size_t)(base_address - buffer_address);
 
-	auto get_shader_ptr = [&](size_t index) {
-		return shader_handle_storage.data() + (handle_size_aligned * index);
+	std::vector<uint8_t> sbt_data(sbt_size + base_alignment);
+
+	auto write_handles = [&](uint32_t first_group, uint32_t count, uint32_t region_offset, uint32_t stride) {
+		for (uint32_t i = 0; i < count; i++)
+		{
+			memcpy(sbt_data.data() + base_offset + region_offset + (i * stride),
+				shader_handle_storage.data() + ((first_group + i) * handle_size), handle_size);
+		}
 	};
 
-	WriteToBuffer(raygen_memory, get_shader_ptr(0), handle_size * raygen_shader_count);
-	WriteToBuffer(miss_memory, get_shader_ptr(raygen_shader_count), handle_size * miss_shader_count);
-	WriteToBuffer(hit_memory, get_shader_ptr(raygen_shader_count + miss_shader_count), handle_size * hit_shader_count);
+	write_handles(0, raygen_shader_count, raygen_offset, raygen_stride);
+	write_handles(raygen_shader_count, miss_shader_count, miss_offset, handle_size_aligned);
+	write_handles(raygen_shader_count + miss_shader_count, hit_shader_count, hit_offset, handle_size_aligned);
+
+	WriteToBuffer(memory, sbt_data.data(), sbt_data.size());
 
 	auto raygen_address = vk::StridedDeviceAddressRegionKHR()
-		.setStride(handle_size_aligned)
-		.setSize(handle_size_aligned)
-		.setDeviceAddress(GetBufferDeviceAddress(*raygen_buffer));
+		.setStride(raygen_stride)
+		.setSize(raygen_size)
+		.setDeviceAddress(base_address + raygen_offset);
 
 	auto miss_address = vk::StridedDeviceAddressRegionKHR()
 		.setStride(handle_size_aligned)
-		.setSize(handle_size_aligned)
-		.setDeviceAddress(GetBufferDeviceAddress(*miss_buffer));
+		.setSize(miss_size)
+		.setDeviceAddress(base_address + miss_offset);
 
 	auto hit_address = vk::StridedDeviceAddressRegionKHR()
 		.setStride(handle_size_aligned)
-		.setSize(handle_size_aligned)
-		.setDeviceAddress(GetBufferDeviceAddress(*hit_buffer));
+		.setSize(hit_size)
+		.setDeviceAddress(base_address + hit_offset);
 
 	auto callable_shader_binding_table = vk::StridedDeviceAddressRegionKHR();
 
 	return RaytracingShaderBindingTable{
-		.raygen_buffer = std::move(raygen_buffer),
-		.raygen_memory = std::move(raygen_memory),
+		.buffer = std::move(buffer),
+		.memory = std::move(memory),
 		.raygen_address = raygen_address,
-
-		.miss_buffer = std::move(miss_buffer),
-		.miss_memory = std::move(miss_memory),
 		.miss_address = miss_address,
-
-		.hit_buffer = std::move(hit_buffer),
-		.hit_memory = std::move(hit_memory),
 		.hit_address = hit_address,
-
 		.callable_address = callable_shader_binding_table
 	};
 }
 
+static const std::unordered_map<InputLayout::Rate, vk::VertexInputRate> InputRateMap = {
+	{ InputLayout::Rate::Vertex, vk::VertexInputRate::eVertex },
+	{ InputLayout::Rate::Instance, vk::VertexInputRate::eInstance },
+};
+
 static vk::raii::Pipeline CreateGraphicsPipeline(const PipelineStateVK& pipeline_state)
 {
 	auto pipeline_shader_stage_create_info = {
@@ -1641,11 +3405,6 @@ static vk::raii::Pipeline CreateGraphicsPipeline(const PipelineStateVK& pipeline
 	{
 		const auto& input_layout = pipeline_state.input_layouts.at(i);
 
-		static const std::unordered_map<InputLayout::Rate, vk::VertexInputRate> InputRateMap = {
-			{ InputLayout::Rate::Vertex, vk::VertexInputRate::eVertex },
-			{ InputLayout::Rate::Instance, vk::VertexInputRate::eInstance },
-		};
-
 		auto vertex_input_binding_description = vk::VertexInputBindingDescription()
 			.setInputRate(InputRateMap.at(input_layout.rate))
 			.setBinding((uint32_t)i);
@@ -1664,14 +3423,11 @@ static vk::raii::Pipeline CreateGraphicsPipeline(const PipelineStateVK& pipeline
 		}
 	}
 
-	// TODO: use dynamic state for InputLayout
-	// https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VK_EXT_vertex_input_dynamic_state.html
-
 	auto pipeline_vertex_input_state_create_info = vk::PipelineVertexInputStateCreateInfo()
 		.setVertexBindingDescriptions(vertex_input_binding_descriptions)
 		.setVertexAttributeDescriptions(vertex_input_attribute_descriptions);
 
-	auto dynamic_states = {
+	std::vector dynamic_states = {
 		vk::DynamicState::eViewport,
 		vk::DynamicState::eScissor,
 		vk::DynamicState::ePrimitiveTopology,
@@ -1688,6 +3444,9 @@ static vk::raii::Pipeline CreateGraphicsPipeline(const PipelineStateVK& pipeline
 		vk::DynamicState::eStencilTestEnable
 	};
 
+	if (gContext->vertex_input_dynamic_state_supported)
+		dynamic_states.push_back(vk::DynamicState::eVertexInputEXT);
+
 	auto pipeline_dynamic_state_create_info = vk::PipelineDynamicStateCreateInfo()
 		.setDynamicStates(dynamic_states);
 
@@ -1760,8 +3519,11 @@ static vk::raii::Pipeline CreateRaytracingPipeline(const RaytracingPipelineState
 		addShader(vk::ShaderStageFlagBits::eMissKHR, vk::RayTracingShaderGroupTypeKHR::eGeneral, miss_module);
 	}
 
-	addShader(vk::ShaderStageFlagBits::eClosestHitKHR, vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup,
-		pipeline_state.shader->getClosestHitShaderModule());
+	for (const auto& closesthit_module : pipeline_state.shader->getClosestHitShaderModules())
+	{
+		addShader(vk::ShaderStageFlagBits::eClosestHitKHR, vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup,
+			closesthit_module);
+	}
 
 	auto raytracing_pipeline_create_info = vk::RayTracingPipelineCreateInfoKHR()
 		.setLayout(*pipeline_state.shader->getPipelineLayout())
@@ -1785,23 +3547,77 @@ static void EnsureVertexBuffers(vk::raii::CommandBuffer& cmdlist)
 
 	for (auto vertex_buffer : gContext->vertex_buffers)
 	{
-		buffers.push_back(*vertex_buffer->getBuffer());
-		offsets.push_back(0);
+		vertex_buffer->ensureUploadCompleted();
+		buffers.push_back(vertex_buffer->getBindBuffer());
+		offsets.push_back(vertex_buffer->getBindOffset());
 		strides.push_back(vertex_buffer->getStride());
 	}
 
 	cmdlist.bindVertexBuffers2(0, buffers, offsets, nullptr, strides);
 }
 
+static void EnsureInputLayouts(vk::raii::CommandBuffer& cmdlist)
+{
+	if (!gContext->vertex_input_dynamic_state_supported)
+		return;
+
+	// the binding descriptions carry the strides of the bound vertex buffers, so they are
+	// set again when a buffer with another stride is bound under the same layouts
+
+	std::vector<uint32_t> strides;
+
+	for (size_t i = 0; i < gContext->input_layouts.size(); i++)
+	{
+		auto stride = i < gContext->vertex_buffers.size() ? gContext->vertex_buffers.at(i)->getStride() : 0;
+		strides.push_back((uint32_t)stride);
+	}
+
+	if (!gContext->input_layouts_dirty && gContext->input_layout_strides == strides)
+		return;
+
+	gContext->input_layouts_dirty = false;
+	gContext->input_layout_strides = strides;
+
+	std::vector<vk::VertexInputBindingDescription2EXT> vertex_input_binding_descriptions;
+	std::vector<vk::VertexInputAttributeDescription2EXT> vertex_input_attribute_descriptions;
+
+	for (size_t i = 0; i < gContext->input_layouts.size(); i++)
+	{
+		const auto& input_layout = gContext->input_layouts.at(i);
+
+		auto vertex_input_binding_description = vk::VertexInputBindingDescription2EXT()
+			.setBinding((uint32_t)i)
+			.setStride(strides.at(i))
+			.setInputRate(InputRateMap.at(input_layout.rate))
+			.setDivisor(1);
+
+		vertex_input_binding_descriptions.push_back(vertex_input_binding_description);
+
+		for (const auto& [location, attribute] : input_layout.attributes)
+		{
+			auto vertex_input_attribute_description = vk::VertexInputAttributeDescription2EXT()
+				.setBinding((uint32_t)i)
+				.setLocation(location)
+				.setFormat(VertexFormatMap.at(attribute.format))
+				.setOffset((uint32_t)attribute.offset);
+
+			vertex_input_attribute_descriptions.push_back(vertex_input_attribute_description);
+		}
+	}
+
+	cmdlist.setVertexInputEXT(vertex_input_binding_descriptions, vertex_input_attribute_descriptions);
+}
+
 static void EnsureIndexBuffer(vk::raii::CommandBuffer& cmdlist)
 {
 	if (!gContext->index_buffer_dirty)
 		return;
 
 	gContext->index_buffer_dirty = false;
-	
+	gContext->index_buffer->ensureUploadCompleted();
+
 	auto index_type = GetIndexTypeFromStride(gContext->index_buffer->getStride());
-	cmdlist.bindIndexBuffer(*gContext->index_buffer->getBuffer(), 0, index_type);
+	cmdlist.bindIndexBuffer(gContext->index_buffer->getBindBuffer(), gContext->index_buffer->getBindOffset(), index_type);
 }
 
 static void EnsureTopology(vk::raii::CommandBuffer& cmdlist)
@@ -2023,66 +3839,252 @@ static void EnsureStencilMode(vk::raii::CommandBuffer& cmdlist)
 	cmdlist.setStencilTestEnable(gContext->stencil_mode.has_value());
 }
 
-static void EnsureGraphicsPipelineState(vk::raii::CommandBuffer& cmdlist)
+template <class T>
+static bool EnsurePipelineCompiled(std::unordered_map<T, vk::raii::Pipeline>& pipelines,
+	std::unordered_map<T, std::future<vk::raii::Pipeline>>& pending_pipelines, const T& pipeline_state,
+	vk::raii::Pipeline(*create_pipeline)(const T&))
 {
-	if (!gContext->pipeline_state_dirty)
-		return;
+	if (pipelines.contains(pipeline_state))
+		return true;
 
-	gContext->pipeline_state_dirty = false;
+	auto it = pending_pipelines.find(pipeline_state);
 
-	if (!gContext->pipeline_states.contains(gContext->pipeline_state))
+	if (it == pending_pipelines.end())
 	{
-		auto pipeline = CreateGraphicsPipeline(gContext->pipeline_state);
-		gContext->pipeline_states.insert({ gContext->pipeline_state, std::move(pipeline) });
+		if (!gContext->async_pipeline_compilation)
+		{
+			pipelines.insert({ pipeline_state, create_pipeline(pipeline_state) });
+			return true;
+		}
+
+		// the worker gets its own copy of the state and reads only immutable objects
+		it = pending_pipelines.emplace(pipeline_state, std::async(std::launch::async, create_pipeline, pipeline_state)).first;
 	}
 
+	if (gContext->async_pipeline_compilation && it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return false;
+
+	pipelines.insert({ pipeline_state, it->second.get() });
+	pending_pipelines.erase(it);
+	return true;
+}
+
+static bool EnsureGraphicsPipelineState(vk::raii::CommandBuffer& cmdlist)
+{
+	if (!gContext->pipeline_state_dirty)
+		return true;
+
+	if (!EnsurePipelineCompiled(gContext->pipeline_states, gContext->pending_pipeline_states, gContext->pipeline_state,
+		CreateGraphicsPipeline))
+		return false;
+
+	gContext->pipeline_state_dirty = false;
+
 	const auto& pipeline = gContext->pipeline_states.at(gContext->pipeline_state);
 	cmdlist.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline);
 
-	gContext->graphics_pipeline_ignore_bindings.clear();
+	// pipelines with the same layout keep the pushed descriptors and constants
+
+	auto pipeline_layout = *gContext->pipeline_state.shader->getPipelineLayout();
+
+	if (gContext->graphics_pipeline_layout == pipeline_layout)
+		return true;
+
+	gContext->graphics_pipeline_layout = pipeline_layout;
+	gContext->graphics_descriptors_dirty = true;
+	gContext->push_constants_dirty = true;
+	gContext->bindless_descriptor_set_dirty = true;
+	return true;
 }
 
-static void EnsureRaytracingPipelineState(vk::raii::CommandBuffer& cmdlist)
+static bool EnsureRaytracingPipelineState(vk::raii::CommandBuffer& cmdlist)
 {
-	if (!gContext->raytracing_pipeline_states.contains(gContext->raytracing_pipeline_state))
+	const auto& pipeline_state = gContext->raytracing_pipeline_state;
+
+	if (!EnsurePipelineCompiled(gContext->raytracing_pipeline_states, gContext->pending_raytracing_pipeline_states,
+		pipeline_state, CreateRaytracingPipeline))
+		return false;
+
+	const auto& pipeline = gContext->raytracing_pipeline_states.at(pipeline_state);
+
+	if (!gContext->raytracing_shader_binding_tables.contains(pipeline_state))
 	{
-		auto pipeline = CreateRaytracingPipeline(gContext->raytracing_pipeline_state);
-		gContext->raytracing_pipeline_states.insert({ gContext->raytracing_pipeline_state, std::move(pipeline) });
+		auto shader_binding_table = CreateRaytracingShaderBindingTable(pipeline_state, pipeline);
+		gContext->raytracing_shader_binding_tables.insert({ pipeline_state, std::move(shader_binding_table) });
 	}
 
-	const auto& pipeline = gContext->raytracing_pipeline_states.at(gContext->raytracing_pipeline_state);
 	cmdlist.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, *pipeline);
+	return true;
+}
+
+static uint32_t GetPendingPipelinesCount()
+{
+	auto is_pending = [](const auto& item) {
+		return item.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+	};
+
+	auto count = std::ranges::count_if(gContext->pending_pipeline_states, is_pending) +
+		std::ranges::count_if(gContext->pending_raytracing_pipeline_states, is_pending);
+
+	return (uint32_t)count;
 }
 
 static void EnsureGraphicsDescriptors(vk::raii::CommandBuffer& cmdlist)
 {
-	const auto& pipeline_layout = gContext->pipeline_state.shader->getPipelineLayout();
-	const auto& required_descriptor_bindings = gContext->pipeline_state.shader->getRequiredDescriptorBindings();
-	auto& ignore_bindings = gContext->graphics_pipeline_ignore_bindings;
+	auto shader = gContext->pipeline_state.shader;
+	const auto& required_descriptor_bindings = shader->getRequiredDescriptorBindings();
+
+	if (!gContext->graphics_descriptors_dirty)
+	{
+		auto is_binding_dirty = [](const vk::DescriptorSetLayoutBinding& descriptor_binding) {
+			return gContext->dirty_descriptor_bindings.contains(descriptor_binding.binding);
+		};
+
+		if (std::none_of(required_descriptor_bindings.begin(), required_descriptor_bindings.end(), is_binding_dirty))
+			return;
+	}
+
+	gContext->graphics_descriptors_dirty = false;
+	gContext->dirty_descriptor_bindings.clear();
+
+	PushDescriptors(cmdlist, shader->getPipelineLayout(), shader->getDescriptorUpdateTemplate(), required_descriptor_bindings);
+}
+
+static void PushConstants(vk::raii::CommandBuffer& cmdlist, const vk::raii::PipelineLayout& pipeline_layout,
+	const std::optional<vk::PushConstantRange>& push_constant_range)
+{
+	if (!push_constant_range.has_value())
+		return;
+
+	const auto& range = push_constant_range.value();
+
+	// bytes the shader declares but were not set are pushed as zeros
+	if (gContext->push_constants.size() < range.size)
+		gContext->push_constants.resize(range.size, 0);
+
+	cmdlist.pushConstants<uint8_t>(*pipeline_layout, range.stageFlags, 0,
+		vk::ArrayProxy<const uint8_t>(range.size, gContext->push_constants.data()));
+}
+
+static void EnsureGraphicsPushConstants(vk::raii::CommandBuffer& cmdlist)
+{
+	if (!gContext->push_constants_dirty)
+		return;
+
+	gContext->push_constants_dirty = false;
 
-	PushDescriptors(cmdlist, vk::PipelineBindPoint::eGraphics, pipeline_layout, required_descriptor_bindings, ignore_bindings);
+	auto shader = gContext->pipeline_state.shader;
+	PushConstants(cmdlist, shader->getPipelineLayout(), shader->getPushConstantRange());
+}
 
-	for (const auto& descriptor_binding : required_descriptor_bindings)
+static void EnsureBindlessTexturesState()
+{
+	for (auto texture : gContext->bindless_textures_to_restore)
 	{
-		ignore_bindings.insert(descriptor_binding.binding);
+		texture->ensureState(vk::ImageLayout::eGeneral);
 	}
+
+	gContext->bindless_textures_to_restore.clear();
+}
+
+static void BindBindlessDescriptorSet(vk::raii::CommandBuffer& cmdlist, vk::PipelineBindPoint pipeline_bind_point,
+	const vk::raii::PipelineLayout& pipeline_layout)
+{
+	cmdlist.bindDescriptorSets(pipeline_bind_point, *pipeline_layout, BindlessTexturesSet,
+		{ *gContext->bindless_descriptor_set }, {});
+}
+
+static void EnsureGraphicsBindlessTextures(vk::raii::CommandBuffer& cmdlist)
+{
+	auto shader = gContext->pipeline_state.shader;
+
+	if (!shader->usesBindlessTextures())
+		return;
+
+	EnsureBindlessTexturesState();
+
+	if (!gContext->bindless_descriptor_set_dirty)
+		return;
+
+	gContext->bindless_descriptor_set_dirty = false;
+
+	BindBindlessDescriptorSet(cmdlist, vk::PipelineBindPoint::eGraphics, shader->getPipelineLayout());
 }
 
 static void EnsureRaytracingDescriptors(vk::raii::CommandBuffer& cmdlist)
 {
-	const auto& pipeline_layout = gContext->raytracing_pipeline_state.shader->getPipelineLayout();
-	const auto& required_descriptor_bindings = gContext->raytracing_pipeline_state.shader->getRequiredDescriptorBindings();
+	auto shader = gContext->raytracing_pipeline_state.shader;
+
+	PushDescriptors(cmdlist, shader->getPipelineLayout(), shader->getDescriptorUpdateTemplate(),
+		shader->getRequiredDescriptorBindings());
+	PushConstants(cmdlist, shader->getPipelineLayout(), shader->getPushConstantRange());
+
+	if (shader->usesBindlessTextures())
+	{
+		EnsureBindlessTexturesState();
+		BindBindlessDescriptorSet(cmdlist, vk::PipelineBindPoint::eRayTracingKHR, shader->getPipelineLayout());
+	}
+
+	// the graphics shader has to push its own constants again
+	gContext->push_constants_dirty = true;
+}
+
+static void EnsureDescriptorResourcesState(const std::vector<vk::DescriptorSetLayoutBinding>& descriptor_bindings)
+{
+	for (const auto& descriptor_binding : descriptor_bindings)
+	{
+		auto binding = descriptor_binding.binding;
+		auto type = descriptor_binding.descriptorType;
+
+		if (type == vk::DescriptorType::eCombinedImageSampler)
+			gContext->textures.at(binding)->ensureState(vk::ImageLayout::eGeneral);
+		else if (type == vk::DescriptorType::eStorageImage)
+			gContext->render_targets.at(0)->getTexture()->ensureState(vk::ImageLayout::eGeneral);
+		else if (type == vk::DescriptorType::eUniformBuffer)
+			gContext->uniform_buffers.at(binding)->ensureUploadCompleted();
+		else if (type == vk::DescriptorType::eStorageBuffer)
+			gContext->storage_buffers.at(binding)->ensureUploadCompleted();
+	}
+}
+
+static void EnsureGraphicsResourcesState(bool draw_indexed)
+{
+	// this runs before anything of the draw is recorded: waiting for an upload can submit the
+	// command buffer, and the layouts queued here let an inactive pass flush them and still
+	// fold its pending clears into the load ops instead of being split around the barrier
+
+	for (auto vertex_buffer : gContext->vertex_buffers)
+	{
+		vertex_buffer->ensureUploadCompleted();
+	}
+
+	if (draw_indexed)
+		gContext->index_buffer->ensureUploadCompleted();
+
+	EnsureRenderTargetsState();
+
+	auto shader = gContext->pipeline_state.shader;
+
+	EnsureDescriptorResourcesState(shader->getRequiredDescriptorBindings());
 
-	PushDescriptors(cmdlist, vk::PipelineBindPoint::eRayTracingKHR, pipeline_layout, required_descriptor_bindings);
+	if (shader->usesBindlessTextures())
+		EnsureBindlessTexturesState();
 }
 
-static void EnsureGraphicsState(bool draw_indexed)
+static bool EnsureGraphicsState(bool draw_indexed)
 {
 	auto& cmdlist = gContext->getCurrentFrame().command_buffer;
 
-	EnsureMemoryState(cmdlist, vk::PipelineStageFlagBits2::eAllGraphics);
-	EnsureGraphicsPipelineState(cmdlist);
+	EnsureGraphicsResourcesState(draw_indexed);
+
+	if (!EnsureGraphicsPipelineState(cmdlist))
+		return false;
+
+	EnsureMemoryState(vk::PipelineStageFlagBits2::eAllGraphics);
 	EnsureGraphicsDescriptors(cmdlist);
+	EnsureGraphicsPushConstants(cmdlist);
+	EnsureGraphicsBindlessTextures(cmdlist);
+	EnsureInputLayouts(cmdlist);
 	EnsureVertexBuffers(cmdlist);
 
 	if (draw_indexed)
@@ -2096,17 +4098,32 @@ static void EnsureGraphicsState(bool draw_indexed)
 	EnsureBlendMode(cmdlist);
 	EnsureDepthMode(cmdlist);
 	EnsureStencilMode(cmdlist);
+
+	// barriers are not allowed inside of a render pass, so only a layout change of a resource
+	// while the pass is open ends it, the pending clears stay for the next pass to load
+	if (gContext->render_pass_active && HasPendingBarriers())
+		EndRenderPass();
+
+	FlushBarriers(cmdlist);
 	EnsureRenderPassActivated();
+	return true;
 }
 
-static void EnsureRaytracingState()
+static bool EnsureRaytracingState()
 {
 	auto& cmdlist = gContext->getCurrentFrame().command_buffer;
 
+	// waiting for an upload can submit the command buffer, so it is done before anything is recorded
+	EnsureDescriptorResourcesState(gContext->raytracing_pipeline_state.shader->getRequiredDescriptorBindings());
+
+	if (!EnsureRaytracingPipelineState(cmdlist))
+		return false;
+
 	EnsureRenderPassDeactivated();
-	EnsureMemoryState(cmdlist, vk::PipelineStageFlagBits2::eAllGraphics);
-	EnsureRaytracingPipelineState(cmdlist);
+	EnsureMemoryState(vk::PipelineStageFlagBits2::eRayTracingShaderKHR);
 	EnsureRaytracingDescriptors(cmdlist);
+	FlushBarriers(cmdlist);
+	return true;
 }
 
 static void WaitForGpu()
@@ -2116,6 +4133,129 @@ static void WaitForGpu()
 	ReleaseStaging();
 }
 
+static void WaitForAllFrames()
+{
+	for (auto& frame : gContext->frames)
+	{
+		auto wait_result = gContext->device.waitForFences({ *frame.fence }, true, UINT64_MAX);
+
+		gContext->free_bindless_indices.insert(gContext->free_bindless_indices.end(),
+			frame.released_bindless_indices.begin(), frame.released_bindless_indices.end());
+		frame.released_bindless_indices.clear();
+	}
+
+	ReleaseDestroyedObjects();
+}
+
+static void CreateBindlessDescriptorSet()
+{
+	auto properties = gContext->physical_device.getProperties2<vk::PhysicalDeviceProperties2,
+		vk::PhysicalDeviceDescriptorIndexingProperties>();
+
+	const auto& descriptor_indexing_properties = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+
+	gContext->bindless_textures_capacity = std::min({ (uint32_t)65536,
+		descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+		descriptor_indexing_properties.maxDescriptorSetUpdateAfterBindSamplers,
+		descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		descriptor_indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+	vk::ShaderStageFlags stage_flags = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+	if (gContext->raytracing_enabled)
+		stage_flags |= vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eMissKHR |
+			vk::ShaderStageFlagBits::eClosestHitKHR;
+
+	auto binding = vk::DescriptorSetLayoutBinding()
+		.setBinding(0)
+		.setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+		.setDescriptorCount(gContext->bindless_textures_capacity)
+		.setStageFlags(stage_flags);
+
+	// unused slots stay empty, and new slots can be written while frames in flight still use the set
+	vk::DescriptorBindingFlags binding_flags = vk::DescriptorBindingFlagBits::ePartiallyBound |
+		vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+
+	auto binding_flags_create_info = vk::DescriptorSetLayoutBindingFlagsCreateInfo()
+		.setBindingFlags(binding_flags);
+
+	auto descriptor_set_layout_create_info = vk::DescriptorSetLayoutCreateInfo()
+		.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+		.setBindings(binding)
+		.setPNext(&binding_flags_create_info);
+
+	gContext->bindless_descriptor_set_layout = gContext->device.createDescriptorSetLayout(descriptor_set_layout_create_info);
+
+	auto pool_size = vk::DescriptorPoolSize()
+		.setType(vk::DescriptorType::eCombinedImageSampler)
+		.setDescriptorCount(gContext->bindless_textures_capacity);
+
+	auto descriptor_pool_create_info = vk::DescriptorPoolCreateInfo()
+		.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind | vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet)
+		.setMaxSets(1)
+		.setPoolSizes(pool_size);
+
+	gContext->bindless_descriptor_pool = gContext->device.createDescriptorPool(descriptor_pool_create_info);
+
+	auto descriptor_set_allocate_info = vk::DescriptorSetAllocateInfo()
+		.setDescriptorPool(*gContext->bindless_descriptor_pool)
+		.setSetLayouts(*gContext->bindless_descriptor_set_layout);
+
+	gContext->bindless_descriptor_set = std::move(gContext->device.allocateDescriptorSets(descriptor_set_allocate_info).at(0));
+
+	auto sampler_state = SamplerStateVK{
+		.sampler = Sampler::Linear,
+		.texture_address = TextureAddress::Wrap
+	};
+
+	gContext->bindless_sampler = CreateSamplerState(sampler_state);
+}
+
+static void CreateFrames(uint32_t count)
+{
+	gContext->frames.clear();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto frame = ContextVK::Frame();
+
+		auto fence_info = vk::FenceCreateInfo()
+			.setFlags(vk::FenceCreateFlagBits::eSignaled);
+
+		frame.fence = gContext->device.createFence(fence_info);
+		frame.image_acquired_semaphore = gContext->device.createSemaphore({});
+
+		auto command_buffer_allocate_info = vk::CommandBufferAllocateInfo()
+			.setCommandBufferCount(1)
+			.setLevel(vk::CommandBufferLevel::ePrimary)
+			.setCommandPool(*gContext->command_pool);
+
+		auto command_buffers = gContext->device.allocateCommandBuffers(command_buffer_allocate_info);
+
+		frame.command_buffer = std::move(command_buffers.at(0));
+
+		gContext->frames.push_back(std::move(frame));
+	}
+
+	gContext->frame_index = 0;
+}
+
+static vk::PresentModeKHR ChoosePresentMode(bool vsync)
+{
+	if (vsync)
+		return vk::PresentModeKHR::eFifo; // always supported
+
+	auto present_modes = gContext->physical_device.getSurfacePresentModesKHR(*gContext->surface);
+
+	for (auto present_mode : { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate })
+	{
+		if (std::find(present_modes.begin(), present_modes.end(), present_mode) != present_modes.end())
+			return present_mode;
+	}
+
+	return vk::PresentModeKHR::eFifo;
+}
+
 static void CreateSwapchain(uint32_t width, uint32_t height)
 {
 	auto surface_capabilities = gContext->physical_device.getSurfaceCapabilitiesKHR(*gContext->surface);
@@ -2156,78 +4296,128 @@ static void CreateSwapchain(uint32_t width, uint32_t height)
 		.setImageArrayLayers(1)
 		.setImageSharingMode(vk::SharingMode::eExclusive)
 		.setQueueFamilyIndices(gContext->queue_family_index)
-		.setPresentMode(vk::PresentModeKHR::eFifo)
+		.setPresentMode(gContext->present_mode)
 		.setClipped(true)
 		.setCompositeAlpha(vk::CompositeAlphaFlagBitsKHR::eOpaque)
 		.setOldSwapchain(*gContext->swapchain);
 
 	gContext->swapchain = gContext->device.createSwapchainKHR(swapchain_info);
 
-	auto backbuffers = gContext->swapchain.getImages();
+	auto images = gContext->swapchain.getImages();
 
-	gContext->frames.clear();
+	gContext->backbuffers.clear();
 
-	for (auto& backbuffer : backbuffers)
+	for (auto& image : images)
 	{
-		auto frame = ContextVK::Frame();
+		auto backbuffer = ContextVK::Backbuffer();
+		backbuffer.texture = std::make_shared<TextureVK>(gContext->width, gContext->height, format, image);
+		backbuffer.target = std::make_shared<RenderTargetVK>(gContext->width, gContext->height, backbuffer.texture.get());
+		backbuffer.render_complete_semaphore = gContext->device.createSemaphore({});
+		gContext->backbuffers.push_back(std::move(backbuffer));
+	}
+}
 
-		auto fence_info = vk::FenceCreateInfo()
-			.setFlags(vk::FenceCreateFlagBits::eSignaled);
+static void AcquireNextImage()
+{
+	const auto& image_acquired_semaphore = gContext->getCurrentFrame().image_acquired_semaphore;
 
-		frame.fence = gContext->device.createFence(fence_info);
+	auto [result, image_index] = gContext->swapchain.acquireNextImage(UINT64_MAX, *image_acquired_semaphore);
 
-		frame.image_acquired_semaphore = gContext->device.createSemaphore({});
-		frame.render_complete_semaphore = gContext->device.createSemaphore({});
+	gContext->image_index = image_index;
+}
 
-		auto command_buffer_allocate_info = vk::CommandBufferAllocateInfo()
-			.setCommandBufferCount(1)
-			.setLevel(vk::CommandBufferLevel::ePrimary)
-			.setCommandPool(*gContext->command_pool);
+static void BeginCommandBuffer()
+{
+	gContext->pipeline_state_dirty = true;
+	gContext->topology_dirty = true;
+	gContext->viewport_dirty = true;
+	gContext->scissor_dirty = true;
+	gContext->cull_mode_dirty = true;
+	gContext->front_face_dirty = true;
+	gContext->vertex_buffers_dirty = true;
+	gContext->input_layouts_dirty = true;
+	gContext->index_buffer_dirty = true;
+	gContext->blend_mode_dirty = true;
+	gContext->depth_mode_dirty = true;
+	gContext->stencil_mode_dirty = true;
+	gContext->graphics_descriptors_dirty = true;
+	gContext->push_constants_dirty = true;
+	gContext->bindless_descriptor_set_dirty = true;
+	gContext->graphics_pipeline_layout = nullptr;
+
+	auto begin_info = vk::CommandBufferBeginInfo()
+		.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+	gContext->getCurrentFrame().command_buffer.begin(begin_info);
+}
+
+static vk::SubmitInfo MakeFrameSubmitInfo(const vk::PipelineStageFlags& wait_dst_stage_mask)
+{
+	const auto& frame = gContext->getCurrentFrame();
 
-		auto command_buffers = gContext->device.allocateCommandBuffers(command_buffer_allocate_info);
+	auto submit_info = vk::SubmitInfo()
+		.setCommandBuffers(*frame.command_buffer);
 
-		frame.command_buffer = std::move(command_buffers.at(0));
+	// only the first submit of the frame waits for the acquired image
 
-		frame.swapchain_texture = std::make_shared<TextureVK>(gContext->width, gContext->height, format, backbuffer);
-		frame.swapchain_target = std::make_shared<RenderTargetVK>(gContext->width, gContext->height, frame.swapchain_texture.get());
+	if (!gContext->image_acquired_semaphore_waited)
+	{
+		submit_info
+			.setWaitDstStageMask(wait_dst_stage_mask)
+			.setWaitSemaphores(*frame.image_acquired_semaphore);
 
-		gContext->frames.push_back(std::move(frame));
+		gContext->image_acquired_semaphore_waited = true;
 	}
 
-	gContext->frame_index = 0;
-	gContext->semaphore_index = 0;
+	return submit_info;
 }
 
-static void MoveToNextFrame()
+static void FlushCommandBuffer()
 {
-	const auto& image_acquired_semaphore = gContext->frames.at(gContext->semaphore_index).image_acquired_semaphore;
+	// submits everything recorded so far, waits for it and continues recording the frame
 
-	auto [result, image_index] = gContext->swapchain.acquireNextImage(UINT64_MAX, *image_acquired_semaphore);
+	EnsureRenderPassDeactivated();
+	FlushBarriers(gContext->getCurrentFrame().command_buffer);
+	FlushReleaseBarriers();
+
+	gContext->getCurrentFrame().command_buffer.end();
+
+	auto wait_dst_stage_mask = vk::PipelineStageFlags{
+		vk::PipelineStageFlagBits::eAllCommands
+	};
 
-	gContext->frame_index = image_index;
+	auto timeline_value = ++gContext->submitted_timeline_value;
+
+	auto timeline_submit_info = vk::TimelineSemaphoreSubmitInfo()
+		.setSignalSemaphoreValues(timeline_value);
+
+	auto submit_info = MakeFrameSubmitInfo(wait_dst_stage_mask)
+		.setSignalSemaphores(*gContext->timeline_semaphore)
+		.setPNext(&timeline_submit_info);
+
+	gContext->queue.submit(submit_info);
+
+	auto wait_info = vk::SemaphoreWaitInfo()
+		.setSemaphores(*gContext->timeline_semaphore)
+		.setValues(timeline_value);
+
+	auto wait_result = gContext->device.waitSemaphores(wait_info, UINT64_MAX);
+
+	ReleaseDestroyedObjects();
+	BeginCommandBuffer();
 }
 
 static void Begin()
 {
 	assert(!gContext->working);
 	gContext->working = true;
+	gContext->image_acquired_semaphore_waited = false;
 
-	gContext->pipeline_state_dirty = true;
-	gContext->topology_dirty = true;
-	gContext->viewport_dirty = true;
-	gContext->scissor_dirty = true;
-	gContext->cull_mode_dirty = true;
-	gContext->front_face_dirty = true;
-	gContext->vertex_buffers_dirty = true;
-	gContext->index_buffer_dirty = true;
-	gContext->blend_mode_dirty = true;
-	gContext->depth_mode_dirty = true;
-	gContext->stencil_mode_dirty = true;
-
-	auto begin_info = vk::CommandBufferBeginInfo()
-		.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
-
-	gContext->getCurrentFrame().command_buffer.begin(begin_info);
+	BeginCommandBuffer();
+	RunPendingDestroys();
+	FlushAcquireBarriers();
+	PollUploads();
+	CompactBottomLevelAccelerationStructures();
 }
 
 static void End()
@@ -2236,9 +4426,11 @@ static void End()
 	gContext->working = false;
 
 	EnsureRenderPassDeactivated();
+	ApplyStoreActions();
+	FlushReleaseBarriers();
 
-	gContext->getCurrentFrame().swapchain_texture->ensureState(gContext->getCurrentFrame().command_buffer,
-		vk::ImageLayout::ePresentSrcKHR);
+	gContext->getCurrentBackbuffer().texture->ensureState(vk::ImageLayout::ePresentSrcKHR);
+	FlushBarriers(gContext->getCurrentFrame().command_buffer);
 
 	gContext->getCurrentFrame().command_buffer.end();
 
@@ -2250,11 +4442,21 @@ static void End()
 		vk::PipelineStageFlagBits::eAllCommands
 	};
 
-	auto submit_info = vk::SubmitInfo()
-		.setWaitDstStageMask(wait_dst_stage_mask)
-		.setWaitSemaphores(*frame.image_acquired_semaphore)
-		.setCommandBuffers(*frame.command_buffer)
-		.setSignalSemaphores(*frame.render_complete_semaphore);
+	auto signal_semaphores = std::array{
+		*gContext->getCurrentBackbuffer().render_complete_semaphore,
+		*gContext->timeline_semaphore
+	};
+
+	// the value for the binary semaphore is ignored
+
+	auto signal_values = std::array<uint64_t, 2>{ 0, ++gContext->submitted_timeline_value };
+
+	auto timeline_submit_info = vk::TimelineSemaphoreSubmitInfo()
+		.setSignalSemaphoreValues(signal_values);
+
+	auto submit_info = MakeFrameSubmitInfo(wait_dst_stage_mask)
+		.setSignalSemaphores(signal_semaphores)
+		.setPNext(&timeline_submit_info);
 
 	gContext->queue.submit(submit_info, *frame.fence);
 }
@@ -2447,6 +4649,22 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 		}
 	}
 
+	for (size_t i = 0; i < properties.size(); i++)
+	{
+		auto queue_flags = properties[i].queueFlags;
+
+		// a family with transfer only is usually backed by the dma engines
+
+		if (!(queue_flags & vk::QueueFlagBits::eTransfer))
+			continue;
+
+		if (queue_flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))
+			continue;
+
+		gContext->transfer_queue_family_index = static_cast<uint32_t>(i);
+		break;
+	}
+
 	auto all_device_extensions = gContext->physical_device.enumerateDeviceExtensionProperties();
 
 	for (auto device_extension : all_device_extensions)
@@ -2454,6 +4672,12 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 	//	std::cout << device_extension.extensionName << std::endl;
 	}
 
+	auto is_device_extension_supported = [&](std::string_view name) {
+		return std::any_of(all_device_extensions.begin(), all_device_extensions.end(), [&](const auto& device_extension) {
+			return name == device_extension.extensionName.data();
+		});
+	};
+
 	std::vector device_extensions = {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 
@@ -2462,7 +4686,14 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 		VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
 	};
 
-	if (features.contains(Feature::Raytracing))
+	gContext->memory_budget_supported = is_device_extension_supported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	if (gContext->memory_budget_supported)
+		device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	gContext->raytracing_enabled = features.contains(Feature::Raytracing);
+
+	if (gContext->raytracing_enabled)
 	{
 		device_extensions.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
 		device_extensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
@@ -2471,27 +4702,86 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 
 	auto queue_priority = { 1.0f };
 
-	auto queue_info = vk::DeviceQueueCreateInfo()
+	std::vector<vk::DeviceQueueCreateInfo> queue_infos;
+
+	queue_infos.push_back(vk::DeviceQueueCreateInfo()
 		.setQueueFamilyIndex(gContext->queue_family_index)
-		.setQueuePriorities(queue_priority);
+		.setQueuePriorities(queue_priority));
+
+	if (gContext->transfer_queue_family_index.has_value())
+	{
+		queue_infos.push_back(vk::DeviceQueueCreateInfo()
+			.setQueueFamilyIndex(gContext->transfer_queue_family_index.value())
+			.setQueuePriorities(queue_priority));
+	}
 
 	auto default_device_features = gContext->physical_device.getFeatures2<
 		vk::PhysicalDeviceFeatures2,
 		vk::PhysicalDeviceVulkan13Features,
-		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT
+		vk::PhysicalDeviceTimelineSemaphoreFeatures,
+		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT,
+		vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT,
+		vk::PhysicalDeviceDescriptorIndexingFeatures
 	>();
 
 	auto raytracing_device_features = gContext->physical_device.getFeatures2<
 		vk::PhysicalDeviceFeatures2,
 		vk::PhysicalDeviceVulkan13Features,
+		vk::PhysicalDeviceTimelineSemaphoreFeatures,
 		vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT,
+		vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT,
+		vk::PhysicalDeviceDescriptorIndexingFeatures,
 		vk::PhysicalDeviceBufferAddressFeaturesEXT,
 		vk::PhysicalDeviceRayTracingPipelineFeaturesKHR,
 		vk::PhysicalDeviceAccelerationStructureFeaturesKHR
 	>();
 
+	if (!default_device_features.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>().timelineSemaphore)
+		throw std::runtime_error("timeline semaphores are not supported by this device");
+
+	gContext->bindless_textures_enabled = features.contains(Feature::BindlessTextures);
+
+	if (gContext->bindless_textures_enabled)
+	{
+		const auto& descriptor_indexing_features = default_device_features.get<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+
+		bool bindless_textures_supported =
+			descriptor_indexing_features.runtimeDescriptorArray &&
+			descriptor_indexing_features.descriptorBindingPartiallyBound &&
+			descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+			descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending &&
+			descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing;
+
+		if (!bindless_textures_supported)
+			throw std::runtime_error("bindless textures are not supported by this device");
+	}
+	else
+	{
+		default_device_features.unlink<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+		raytracing_device_features.unlink<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+	}
+
+	auto limits = gContext->physical_device.getProperties().limits;
+
+	gContext->upload_offset_alignment = std::max({ (vk::DeviceSize)16, limits.minUniformBufferOffsetAlignment,
+		limits.minStorageBufferOffsetAlignment });
+
+	gContext->vertex_input_dynamic_state_supported =
+		is_device_extension_supported(VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME) &&
+		default_device_features.get<vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT>().vertexInputDynamicState;
+
+	if (gContext->vertex_input_dynamic_state_supported)
+	{
+		device_extensions.push_back(VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME);
+	}
+	else
+	{
+		default_device_features.unlink<vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT>();
+		raytracing_device_features.unlink<vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT>();
+	}
+
 	auto device_info = vk::DeviceCreateInfo()
-		.setQueueCreateInfos(queue_info)
+		.setQueueCreateInfos(queue_infos)
 		.setPEnabledExtensionNames(device_extensions)
 		.setPEnabledFeatures(nullptr);
 
@@ -2504,6 +4794,26 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 
 	gContext->queue = gContext->device.getQueue(gContext->queue_family_index, 0);
 
+	auto semaphore_type_info = vk::SemaphoreTypeCreateInfo()
+		.setSemaphoreType(vk::SemaphoreType::eTimeline)
+		.setInitialValue(0);
+
+	auto timeline_semaphore_info = vk::SemaphoreCreateInfo()
+		.setPNext(&semaphore_type_info);
+
+	gContext->timeline_semaphore = gContext->device.createSemaphore(timeline_semaphore_info);
+
+	if (gContext->transfer_queue_family_index.has_value())
+	{
+		gContext->transfer_queue = gContext->device.getQueue(gContext->transfer_queue_family_index.value(), 0);
+
+		auto transfer_command_pool_info = vk::CommandPoolCreateInfo()
+			.setFlags(vk::CommandPoolCreateFlagBits::eTransient)
+			.setQueueFamilyIndex(gContext->transfer_queue_family_index.value());
+
+		gContext->transfer_command_pool = gContext->device.createCommandPool(transfer_command_pool_info);
+	}
+
 #if defined(SKYGFX_PLATFORM_WINDOWS)
 	auto surface_info = vk::Win32SurfaceCreateInfoKHR()
 		.setHwnd((HWND)window);
@@ -2550,18 +4860,31 @@ BackendVK::BackendVK(void* window, uint32_t width, uint32_t height, Adapter adap
 
 	gContext->command_pool = gContext->device.createCommandPool(command_pool_info);
 
+	if (gContext->bindless_textures_enabled)
+		CreateBindlessDescriptorSet();
+
 	gContext->pipeline_state.color_attachment_formats = { gContext->surface_format.format };
 	gContext->pipeline_state.depth_stencil_format = ContextVK::DefaultDepthStencilFormat;
 
+	// skygfx starts with vsync disabled, the swapchain is created with its present mode right away
+	// so the vsync setup of Initialize does not recreate it
+	gContext->present_mode = ChoosePresentMode(false);
+
+	CreateFrames(gContext->frames_in_flight);
 	CreateSwapchain(width, height);
-	MoveToNextFrame();
+	AcquireNextImage();
 	Begin();
 }
 
 BackendVK::~BackendVK()
 {
 	End();
-	WaitForGpu();
+	WaitForAllFrames();
+	WaitUpload(gContext->last_upload_id);
+
+	// workers may still read shaders that are deleted with the context
+	gContext->pending_pipeline_states.clear();
+	gContext->pending_raytracing_pipeline_states.clear();
 
 	delete gContext;
 	gContext = nullptr;
@@ -2570,15 +4893,32 @@ BackendVK::~BackendVK()
 void BackendVK::resize(uint32_t width, uint32_t height)
 {
 	End();
-	WaitForGpu();
+	WaitForAllFrames();
 	CreateSwapchain(width, height);
-	MoveToNextFrame();
+	AcquireNextImage();
 	Begin();
 }
 
 void BackendVK::setVsync(bool value)
 {
-	// TODO: implement
+	auto present_mode = ChoosePresentMode(value);
+
+	if (gContext->present_mode == present_mode)
+		return;
+
+	gContext->present_mode = present_mode;
+
+	End();
+	WaitForAllFrames();
+	CreateSwapchain(gContext->width, gContext->height);
+	AcquireNextImage();
+	Begin();
+}
+
+void BackendVK::setFramesInFlight(uint32_t count)
+{
+	assert(count > 0);
+	gContext->frames_in_flight = count; // applied on next present, when no swapchain image is held
 }
 
 void BackendVK::setTopology(Topology topology)
@@ -2601,8 +4941,8 @@ void BackendVK::setScissor(std::optional<Scissor> scissor)
 
 void BackendVK::setTexture(uint32_t binding, TextureHandle* handle)
 {
-	gContext->textures[binding] = (TextureVK*)handle;
-	gContext->graphics_pipeline_ignore_bindings.erase(binding);
+	gContext->textures[binding] = gContext->texture_pool.get(handle);
+	gContext->dirty_descriptor_bindings.insert(binding);
 }
 
 void BackendVK::setRenderTarget(const RenderTarget** render_target, size_t count)
@@ -2620,7 +4960,7 @@ void BackendVK::setRenderTarget(const RenderTarget** render_target, size_t count
 	{
 		for (size_t i = 0; i < count; i++)
 		{
-			auto target = (RenderTargetVK*)(RenderTargetHandle*)*(RenderTarget*)render_target[i];
+			auto target = gContext->render_target_pool.get((RenderTargetHandle*)*(RenderTarget*)render_target[i]);
 			render_targets.push_back(target);
 			color_attachment_formats.push_back(target->getTexture()->getFormat());
 
@@ -2632,11 +4972,15 @@ void BackendVK::setRenderTarget(const RenderTarget** render_target, size_t count
 	if (gContext->render_targets.size() != render_targets.size())
 		gContext->blend_mode_dirty = true;
 
+	EnsureRenderPassDeactivated();
+
+	if (gContext->render_targets != render_targets)
+		ApplyStoreActions();
+
 	gContext->pipeline_state_dirty = true;
 	gContext->pipeline_state.color_attachment_formats = color_attachment_formats;
 	gContext->pipeline_state.depth_stencil_format = depth_stencil_format;
 	gContext->render_targets = render_targets;
-	EnsureRenderPassDeactivated();
 
 	if (!gContext->viewport.has_value())
 		gContext->viewport_dirty = true;
@@ -2647,19 +4991,27 @@ void BackendVK::setRenderTarget(const RenderTarget** render_target, size_t count
 
 void BackendVK::setShader(ShaderHandle* handle)
 {
-	gContext->pipeline_state.shader = (ShaderVK*)handle;
+	gContext->pipeline_state.shader = gContext->shader_pool.get(handle);
 	gContext->pipeline_state_dirty = true;
 }
 
 void BackendVK::setInputLayout(const std::vector<InputLayout>& value)
 {
-	gContext->pipeline_state.input_layouts = value;
-	gContext->pipeline_state_dirty = true;
+	if (gContext->vertex_input_dynamic_state_supported)
+	{
+		gContext->input_layouts = value;
+		gContext->input_layouts_dirty = true;
+	}
+	else
+	{
+		gContext->pipeline_state.input_layouts = value;
+		gContext->pipeline_state_dirty = true;
+	}
 }
 
 void BackendVK::setRaytracingShader(RaytracingShaderHandle* handle)
 {
-	auto shader = (RaytracingShaderVK*)handle;
+	auto shader = gContext->raytracing_shader_pool.get(handle);
 	gContext->raytracing_pipeline_state.shader = shader;
 }
 
@@ -2668,7 +5020,7 @@ void BackendVK::setVertexBuffer(const VertexBuffer** vertex_buffer, size_t count
 	gContext->vertex_buffers.clear();
 	for (size_t i = 0; i < count; i++)
 	{
-		auto buffer = (VertexBufferVK*)(VertexBufferHandle*)*(VertexBuffer*)vertex_buffer[i];
+		auto buffer = gContext->vertex_buffer_pool.get((VertexBufferHandle*)*(VertexBuffer*)vertex_buffer[i]);
 		gContext->vertex_buffers.push_back(buffer);
 	}
 	gContext->vertex_buffers_dirty = true;
@@ -2676,24 +5028,59 @@ void BackendVK::setVertexBuffer(const VertexBuffer** vertex_buffer, size_t count
 
 void BackendVK::setIndexBuffer(IndexBufferHandle* handle)
 {
-	gContext->index_buffer = (IndexBufferVK*)handle;
+	gContext->index_buffer = gContext->index_buffer_pool.get(handle);
 	gContext->index_buffer_dirty = true;
 }
 
 void BackendVK::setUniformBuffer(uint32_t binding, UniformBufferHandle* handle)
 {
-	gContext->uniform_buffers[binding] = (UniformBufferVK*)handle;
-	gContext->graphics_pipeline_ignore_bindings.erase(binding);
+	gContext->uniform_buffers[binding] = gContext->uniform_buffer_pool.get(handle);
+	gContext->dirty_descriptor_bindings.insert(binding);
 }
 
 void BackendVK::setStorageBuffer(uint32_t binding, StorageBufferHandle* handle)
 {
-	gContext->storage_buffers[binding] = (StorageBufferVK*)handle;
+	gContext->storage_buffers[binding] = gContext->storage_buffer_pool.get(handle);
+	gContext->dirty_descriptor_bindings.insert(binding);
 }
 
 void BackendVK::setAccelerationStructure(uint32_t binding, TopLevelAccelerationStructureHandle* handle)
 {
-	gContext->top_level_acceleration_structures[binding] = (TopLevelAccelerationStructureVK*)handle;
+	gContext->top_level_acceleration_structures[binding] = gContext->top_level_acceleration_structure_pool.get(handle);
+	gContext->dirty_descriptor_bindings.insert(binding);
+}
+
+uint32_t BackendVK::getBindlessTextureIndex(TextureHandle* handle)
+{
+	auto texture = gContext->texture_pool.get(handle);
+	return texture->getBindlessIndex();
+}
+
+void BackendVK::setAsyncPipelineCompilation(bool value)
+{
+	gContext->async_pipeline_compilation = value;
+}
+
+uint32_t BackendVK::getPendingPipelinesCount()
+{
+	return GetPendingPipelinesCount();
+}
+
+MemoryStats BackendVK::getMemoryStats()
+{
+	return GetMemoryStats();
+}
+
+void BackendVK::setShaderCacheDirectory(const std::string& path)
+{
+}
+
+void BackendVK::setPushConstants(const void* memory, size_t size)
+{
+	assert(size <= gContext->physical_device.getProperties().limits.maxPushConstantsSize);
+
+	gContext->push_constants.assign((const uint8_t*)memory, (const uint8_t*)memory + size);
+	gContext->push_constants_dirty = true;
 }
 
 void BackendVK::setBlendMode(const std::optional<BlendMode>& value)
@@ -2723,16 +5110,19 @@ void BackendVK::setCullMode(CullMode cull_mode)
 void BackendVK::setSampler(Sampler value)
 {
 	gContext->sampler_state.sampler = value;
+	gContext->graphics_descriptors_dirty = true;
 }
 
 void BackendVK::setAnisotropyLevel(AnisotropyLevel value)
 {
 	gContext->sampler_state.anisotropy_level = value;
+	gContext->graphics_descriptors_dirty = true;
 }
 
 void BackendVK::setTextureAddress(TextureAddress value)
 {
 	gContext->sampler_state.texture_address = value;
+	gContext->graphics_descriptors_dirty = true;
 }
 
 void BackendVK::setFrontFace(FrontFace value)
@@ -2745,10 +5135,36 @@ void BackendVK::setDepthBias(const std::optional<DepthBias> depth_bias)
 {
 }
 
+void BackendVK::setStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+	static const std::unordered_map<StoreAction, vk::AttachmentStoreOp> StoreOpMap = {
+		{ StoreAction::Store, vk::AttachmentStoreOp::eStore },
+		{ StoreAction::DontCare, vk::AttachmentStoreOp::eDontCare }
+	};
+
+	// applies once, when the current targets are switched or presented
+	gContext->color_store_op = StoreOpMap.at(color);
+	gContext->depth_stencil_store_op = StoreOpMap.at(depth_stencil);
+}
+
 void BackendVK::clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
-	EnsureRenderPassActivated();
+	if (!gContext->render_pass_active)
+	{
+		// folded into the load ops of the next render pass
+
+		if (color.has_value())
+			gContext->clear_color = color;
+
+		if (depth.has_value())
+			gContext->clear_depth = depth;
+
+		if (stencil.has_value())
+			gContext->clear_stencil = stencil;
+
+		return;
+	}
 
 	auto width = gContext->getBackbufferWidth();
 	auto height = gContext->getBackbufferHeight();
@@ -2768,12 +5184,19 @@ void BackendVK::clear(const std::optional<glm::vec4>& color, const std::optional
 		auto clear_value = vk::ClearValue()
 			.setColor(clear_color_value);
 		
-		auto attachment = vk::ClearAttachment()
-			.setAspectMask(vk::ImageAspectFlagBits::eColor)
-			.setColorAttachment(0) // TODO: clear all attachments
-			.setClearValue(clear_value);
+		std::vector<vk::ClearAttachment> attachments;
 
-		gContext->getCurrentFrame().command_buffer.clearAttachments({ attachment }, { clear_rect });
+		for (uint32_t i = 0; i < std::max<uint32_t>((uint32_t)gContext->render_targets.size(), 1); i++)
+		{
+			auto attachment = vk::ClearAttachment()
+				.setAspectMask(vk::ImageAspectFlagBits::eColor)
+				.setColorAttachment(i)
+				.setClearValue(clear_value);
+
+			attachments.push_back(attachment);
+		}
+
+		gContext->getCurrentFrame().command_buffer.clearAttachments(attachments, { clear_rect });
 	}
 
 	if (depth.has_value() || stencil.has_value())
@@ -2804,13 +5227,17 @@ void BackendVK::clear(const std::optional<glm::vec4>& color, const std::optional
 
 void BackendVK::draw(uint32_t vertex_count, uint32_t vertex_offset, uint32_t instance_count)
 {
-	EnsureGraphicsState(false);
+	if (!EnsureGraphicsState(false))
+		return;
+
 	gContext->getCurrentFrame().command_buffer.draw(vertex_count, instance_count, vertex_offset, 0);
 }
 
 void BackendVK::drawIndexed(uint32_t index_count, uint32_t index_offset, uint32_t instance_count)
 {
-	EnsureGraphicsState(true);
+	if (!EnsureGraphicsState(true))
+		return;
+
 	gContext->getCurrentFrame().command_buffer.drawIndexed(index_count, instance_count, index_offset, 0, 0);
 }
 
@@ -2820,7 +5247,7 @@ void BackendVK::copyBackbufferToTexture(const glm::i32vec2& src_pos, const glm::
 	if (size.x <= 0 || size.y <= 0)
 		return;
 
-	auto dst_texture = (TextureVK*)dst_texture_handle;
+	auto dst_texture = gContext->texture_pool.get(dst_texture_handle);
 	auto dst_format = gContext->getBackbufferFormat();
 
 	assert(dst_texture->getWidth() >= static_cast<uint32_t>(dst_pos.x + size.x));
@@ -2829,7 +5256,7 @@ void BackendVK::copyBackbufferToTexture(const glm::i32vec2& src_pos, const glm::
 
 	EnsureRenderPassDeactivated();
 
-	auto src_target = !gContext->render_targets.empty() ? gContext->render_targets.at(0) : gContext->getCurrentFrame().swapchain_target.get();
+	auto src_target = !gContext->render_targets.empty() ? gContext->render_targets.at(0) : gContext->getCurrentBackbuffer().target.get();
 	auto src_texture = src_target->getTexture();
 	auto src_image = src_texture->getImage();
 	auto dst_image = dst_texture->getImage();
@@ -2845,8 +5272,9 @@ void BackendVK::copyBackbufferToTexture(const glm::i32vec2& src_pos, const glm::
 		.setDstOffset({ dst_pos.x, dst_pos.y, 0 })
 		.setExtent({ static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y), 1 });
 
-	src_texture->ensureState(gContext->getCurrentFrame().command_buffer, vk::ImageLayout::eTransferSrcOptimal);
-	dst_texture->ensureState(gContext->getCurrentFrame().command_buffer, vk::ImageLayout::eTransferDstOptimal);
+	src_texture->ensureState(vk::ImageLayout::eTransferSrcOptimal, 0, 1);
+	dst_texture->ensureState(vk::ImageLayout::eTransferDstOptimal, 0, 1);
+	FlushBarriers(gContext->getCurrentFrame().command_buffer);
 
 	auto copy_image_info = vk::CopyImageInfo2()
 		.setSrcImage(src_image)
@@ -2862,10 +5290,10 @@ void BackendVK::dispatchRays(uint32_t width, uint32_t height, uint32_t depth)
 {
 	assert(!gContext->render_targets.empty());
 
-	EnsureRaytracingState();
+	if (!EnsureRaytracingState())
+		return;
 
-	const auto& pipeline = gContext->raytracing_pipeline_states.at(gContext->raytracing_pipeline_state);
-	static auto binding_table = CreateRaytracingShaderBindingTable(pipeline);
+	const auto& binding_table = gContext->raytracing_shader_binding_tables.at(gContext->raytracing_pipeline_state);
 
 	gContext->getCurrentFrame().command_buffer.traceRaysKHR(binding_table.raygen_address, binding_table.miss_address,
 		binding_table.hit_address, binding_table.callable_address, width, height, depth);
@@ -2875,88 +5303,96 @@ void BackendVK::present()
 {
 	End();
 
-	const auto& render_complete_semaphore = gContext->getCurrentFrame().render_complete_semaphore;
+	const auto& render_complete_semaphore = gContext->getCurrentBackbuffer().render_complete_semaphore;
 
 	auto present_info = vk::PresentInfoKHR()
 		.setWaitSemaphores(*render_complete_semaphore)
 		.setSwapchains(*gContext->swapchain)
-		.setImageIndices(gContext->frame_index);
+		.setImageIndices(gContext->image_index);
 
 	auto present_result = gContext->queue.presentKHR(present_info);
 
-	gContext->semaphore_index = (gContext->semaphore_index + 1) % gContext->frames.size();
+	if (gContext->frames.size() != gContext->frames_in_flight)
+	{
+		WaitForAllFrames();
+		CreateFrames(gContext->frames_in_flight);
+	}
+	else
+	{
+		gContext->frame_index = (gContext->frame_index + 1) % gContext->frames.size();
+	}
 
-	MoveToNextFrame();
 	WaitForGpu();
+	AcquireNextImage();
 	Begin();
 }
 
 TextureHandle* BackendVK::createTexture(uint32_t width, uint32_t height, PixelFormat format,
 	uint32_t mip_count)
 {
-	auto texture = new TextureVK(width, height, PixelFormatMap.at(format), mip_count);
-	gContext->objects.insert(texture);
-	return (TextureHandle*)texture;
+	return (TextureHandle*)gContext->texture_pool.create(width, height, PixelFormatMap.at(format), mip_count);
 }
 
 void BackendVK::writeTexturePixels(TextureHandle* handle, uint32_t width, uint32_t height, const void* memory,
 	uint32_t mip_level, uint32_t offset_x, uint32_t offset_y)
 {
-	auto texture = (TextureVK*)handle;
+	auto texture = gContext->texture_pool.get(handle);
 	texture->write(width, height, memory, mip_level, offset_x, offset_y);
 }
 
 std::vector<uint8_t> BackendVK::readTexturePixels(TextureHandle* handle, uint32_t mip_level)
 {
-	auto texture = (TextureVK*)handle;
+	auto texture = gContext->texture_pool.get(handle);
 	return texture->read(mip_level);
 }
 
-void BackendVK::generateMips(TextureHandle* handle)
+void BackendVK::generateMips(TextureHandle* handle, MipmapFilter filter)
 {
-	auto texture = (TextureVK*)handle;
-	texture->generateMips();
+	auto texture = gContext->texture_pool.get(handle);
+	texture->generateMips(filter);
 }
 
 void BackendVK::destroyTexture(TextureHandle* handle)
 {
-	auto texture = (TextureVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyTexture(handle); }))
+		return;
+
+	auto texture = gContext->texture_pool.get(handle);
 	
 	std::erase_if(gContext->textures, [&](const auto& item) {
 		const auto& [binding, _texture] = item;
 		return texture == _texture;
 	});
 
-	gContext->objects.erase(texture);
-	delete texture;
+	gContext->texture_pool.destroy(handle);
 }
 
 RenderTargetHandle* BackendVK::createRenderTarget(uint32_t width, uint32_t height, TextureHandle* texture_handle)
 {
-	auto texture = (TextureVK*)texture_handle;
-	auto render_target = new RenderTargetVK(width, height, texture);
-	gContext->objects.insert(render_target);
-	return (RenderTargetHandle*)render_target;
+	auto texture = gContext->texture_pool.get(texture_handle);
+	return (RenderTargetHandle*)gContext->render_target_pool.create(width, height, texture);
 }
 
 void BackendVK::destroyRenderTarget(RenderTargetHandle* handle)
 {
-	auto render_target = (RenderTargetVK*)handle;
-	gContext->objects.erase(render_target);
-	delete render_target;
+	if (DeferDestroyToRenderThread([this, handle] { destroyRenderTarget(handle); }))
+		return;
+
+	gContext->render_target_pool.destroy(handle);
 }
 
 ShaderHandle* BackendVK::createShader(const std::string& vertex_code, const std::string& fragment_code,
 	const std::vector<std::string>& defines)
 {
-	auto shader = new ShaderVK(vertex_code, fragment_code, defines);
-	gContext->objects.insert(shader);
-	return (ShaderHandle*)shader;
+	return (ShaderHandle*)gContext->shader_pool.create(vertex_code, fragment_code, defines);
 }
 
 void BackendVK::destroyShader(ShaderHandle* handle)
 {
-	auto shader = (ShaderVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyShader(handle); }))
+		return;
+
+	auto shader = gContext->shader_pool.get(handle);
 
 	for (auto& [state, pipeline] : gContext->pipeline_states)
 	{
@@ -2971,48 +5407,71 @@ void BackendVK::destroyShader(ShaderHandle* handle)
 		return state.shader == shader;
 	});
 
-	gContext->objects.erase(shader);
-	delete shader;
+	// destroying a future of std::async waits for the worker, the pipeline was never used
+	std::erase_if(gContext->pending_pipeline_states, [&](const auto& item) {
+		return item.first.shader == shader;
+	});
+
+	gContext->shader_pool.destroy(handle);
 }
 
 RaytracingShaderHandle* BackendVK::createRaytracingShader(const std::string& raygen_code, const std::vector<std::string>& miss_code,
-	const std::string& closesthit_code, const std::vector<std::string>& defines)
+	const std::vector<std::string>& closesthit_code, const std::vector<std::string>& defines)
 {
-	auto shader = new RaytracingShaderVK(raygen_code, miss_code, closesthit_code, defines);
-	gContext->objects.insert(shader);
-	return (RaytracingShaderHandle*)shader;
+	return (RaytracingShaderHandle*)gContext->raytracing_shader_pool.create(raygen_code, miss_code, closesthit_code, defines);
 }
 
 void BackendVK::destroyRaytracingShader(RaytracingShaderHandle* handle)
 {
-	auto shader = (RaytracingShaderVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyRaytracingShader(handle); }))
+		return;
+
+	auto shader = gContext->raytracing_shader_pool.get(handle);
 
 	std::erase_if(gContext->raytracing_pipeline_states, [&](const auto& item) {
 		const auto& [state, pipeline] = item;
 		return state.shader == shader;
 	});
 
-	gContext->objects.erase(shader);
-	delete shader;
+	std::erase_if(gContext->pending_raytracing_pipeline_states, [&](const auto& item) {
+		return item.first.shader == shader;
+	});
+
+	for (auto it = gContext->raytracing_shader_binding_tables.begin(); it != gContext->raytracing_shader_binding_tables.end();)
+	{
+		auto& [state, shader_binding_table] = *it;
+
+		if (state.shader != shader)
+		{
+			++it;
+			continue;
+		}
+
+		DestroyStaging(std::move(shader_binding_table.buffer));
+		DestroyStaging(std::move(shader_binding_table.memory));
+		it = gContext->raytracing_shader_binding_tables.erase(it);
+	}
+
+	gContext->raytracing_shader_pool.destroy(handle);
 }
 
 VertexBufferHandle* BackendVK::createVertexBuffer(size_t size, size_t stride)
 {
-	auto buffer = new VertexBufferVK(size, stride);
-	gContext->objects.insert(buffer);
-	return (VertexBufferHandle*)buffer;
+	return (VertexBufferHandle*)gContext->vertex_buffer_pool.create(size, stride);
 }
 
 void BackendVK::destroyVertexBuffer(VertexBufferHandle* handle)
 {
-	auto buffer = (VertexBufferVK*)handle;
-	gContext->objects.erase(buffer);
-	delete buffer;
+	if (DeferDestroyToRenderThread([this, handle] { destroyVertexBuffer(handle); }))
+		return;
+
+	BuildPendingBottomLevelAccelerationStructuresReading(gContext->vertex_buffer_pool.get(handle));
+	gContext->vertex_buffer_pool.destroy(handle);
 }
 
 void BackendVK::writeVertexBufferMemory(VertexBufferHandle* handle, const void* memory, size_t size, size_t stride)
 {
-	auto buffer = (VertexBufferVK*)handle;
+	auto buffer = gContext->vertex_buffer_pool.get(handle);
 	buffer->write(memory, size);
 	buffer->setStride(stride);
 
@@ -3026,21 +5485,21 @@ void BackendVK::writeVertexBufferMemory(VertexBufferHandle* handle, const void*
 
 IndexBufferHandle* BackendVK::createIndexBuffer(size_t size, size_t stride)
 {
-	auto buffer = new IndexBufferVK(size, stride);
-	gContext->objects.insert(buffer);
-	return (IndexBufferHandle*)buffer;
+	return (IndexBufferHandle*)gContext->index_buffer_pool.create(size, stride);
 }
 
 void BackendVK::destroyIndexBuffer(IndexBufferHandle* handle)
 {
-	auto buffer = (IndexBufferVK*)handle;
-	gContext->objects.erase(buffer);
-	delete buffer;
+	if (DeferDestroyToRenderThread([this, handle] { destroyIndexBuffer(handle); }))
+		return;
+
+	BuildPendingBottomLevelAccelerationStructuresReading(gContext->index_buffer_pool.get(handle));
+	gContext->index_buffer_pool.destroy(handle);
 }
 
 void BackendVK::writeIndexBufferMemory(IndexBufferHandle* handle, const void* memory, size_t size, size_t stride)
 {
-	auto buffer = (IndexBufferVK*)handle;
+	auto buffer = gContext->index_buffer_pool.get(handle);
 	buffer->write(memory, size);
 	buffer->setStride(stride);
 
@@ -3050,92 +5509,190 @@ void BackendVK::writeIndexBufferMemory(IndexBufferHandle* handle, const void* me
 
 UniformBufferHandle* BackendVK::createUniformBuffer(size_t size)
 {
-	auto buffer = new UniformBufferVK(size);
-	gContext->objects.insert(buffer);
-	return (UniformBufferHandle*)buffer;
+	return (UniformBufferHandle*)gContext->uniform_buffer_pool.create(size);
 }
 
 void BackendVK::destroyUniformBuffer(UniformBufferHandle* handle)
 {
-	auto buffer = (UniformBufferVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyUniformBuffer(handle); }))
+		return;
+
+	auto buffer = gContext->uniform_buffer_pool.get(handle);
 
 	std::erase_if(gContext->uniform_buffers, [&](const auto& item) {
 		const auto& [binding, _buffer] = item;
 		return buffer == _buffer;
 	});
 
-	gContext->objects.erase(buffer);
-	delete buffer;
+	gContext->uniform_buffer_pool.destroy(handle);
 }
 
 void BackendVK::writeUniformBufferMemory(UniformBufferHandle* handle, const void* memory, size_t size)
 {
-	auto buffer = (UniformBufferVK*)handle;
+	auto buffer = gContext->uniform_buffer_pool.get(handle);
 	buffer->write(memory, size);
+
+	for (const auto& [binding, uniform_buffer] : gContext->uniform_buffers)
+	{
+		if (uniform_buffer == buffer)
+			gContext->dirty_descriptor_bindings.insert(binding);
+	}
+}
+
+UploadId BackendVK::writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+	const void* memory, uint32_t mip_level)
+{
+	if (!gContext->transfer_queue_family_index.has_value())
+	{
+		writeTexturePixels(handle, width, height, memory, mip_level, 0, 0);
+		return 0;
+	}
+
+	auto texture = gContext->texture_pool.get(handle);
+	return texture->writeAsync(memory, mip_level);
+}
+
+UploadId BackendVK::writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	if (!gContext->transfer_queue_family_index.has_value())
+	{
+		writeVertexBufferMemory(handle, memory, size, stride);
+		return 0;
+	}
+
+	auto buffer = gContext->vertex_buffer_pool.get(handle);
+	buffer->setStride(stride);
+
+	auto has_buffer = std::ranges::any_of(gContext->vertex_buffers, [&](auto vertex_buffer) {
+		return vertex_buffer == buffer;
+	});
+
+	if (has_buffer)
+		gContext->vertex_buffers_dirty = true;
+
+	return buffer->writeAsync(memory, size);
+}
+
+UploadId BackendVK::writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+	size_t stride)
+{
+	if (!gContext->transfer_queue_family_index.has_value())
+	{
+		writeIndexBufferMemory(handle, memory, size, stride);
+		return 0;
+	}
+
+	auto buffer = gContext->index_buffer_pool.get(handle);
+	buffer->setStride(stride);
+
+	if (gContext->index_buffer == buffer)
+		gContext->index_buffer_dirty = true;
+
+	return buffer->writeAsync(memory, size);
+}
+
+bool BackendVK::isUploadCompleted(UploadId id)
+{
+	PollUploads();
+	return id <= gContext->completed_upload_id;
+}
+
+void BackendVK::waitUpload(UploadId id)
+{
+	WaitUpload(id);
 }
 
 BottomLevelAccelerationStructureHandle* BackendVK::createBottomLevelAccelerationStructure(const void* vertex_memory,
 	uint32_t vertex_count, uint32_t vertex_stride, const void* index_memory, uint32_t index_count,
-	uint32_t index_stride, const glm::mat4& transform)
+	uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options)
 {
-	auto bottom_level_acceleration_structure = new BottomLevelAccelerationStructureVK(vertex_memory,
-		vertex_count, vertex_stride, index_memory, index_count, index_stride, transform);
-	gContext->objects.insert(bottom_level_acceleration_structure);
-	return (BottomLevelAccelerationStructureHandle*)bottom_level_acceleration_structure;
+	auto handle = gContext->bottom_level_acceleration_structure_pool.create(vertex_memory, vertex_count,
+		vertex_stride, index_memory, index_count, index_stride, transform, options);
+	gContext->pending_bottom_level_acceleration_structures.push_back((BottomLevelAccelerationStructureHandle*)handle);
+	return (BottomLevelAccelerationStructureHandle*)handle;
+}
+
+BottomLevelAccelerationStructureHandle* BackendVK::createBottomLevelAccelerationStructure(
+	VertexBufferHandle* vertex_buffer_handle, uint32_t vertex_count, uint32_t vertex_offset, uint32_t vertex_stride,
+	VertexFormat vertex_format, IndexBufferHandle* index_buffer_handle, uint32_t index_count, uint32_t index_offset,
+	uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options)
+{
+	auto vertex_buffer = gContext->vertex_buffer_pool.get(vertex_buffer_handle);
+	auto index_buffer = gContext->index_buffer_pool.get(index_buffer_handle);
+	auto handle = gContext->bottom_level_acceleration_structure_pool.create(*vertex_buffer, vertex_count,
+		vertex_offset, vertex_stride, vertex_format, *index_buffer, index_count, index_offset, index_stride, transform, options);
+	gContext->pending_bottom_level_acceleration_structures.push_back((BottomLevelAccelerationStructureHandle*)handle);
+	return (BottomLevelAccelerationStructureHandle*)handle;
 }
 
 void BackendVK::destroyBottomLevelAccelerationStructure(BottomLevelAccelerationStructureHandle* handle)
 {
-	auto bottom_level_acceleration_structure = (BottomLevelAccelerationStructureVK*)handle;
-	gContext->objects.erase(bottom_level_acceleration_structure);
-	delete bottom_level_acceleration_structure;
+	if (DeferDestroyToRenderThread([this, handle] { destroyBottomLevelAccelerationStructure(handle); }))
+		return;
+
+	std::erase(gContext->pending_bottom_level_acceleration_structures, handle);
+	gContext->bottom_level_acceleration_structure_pool.destroy(handle);
 }
 
 TopLevelAccelerationStructureHandle* BackendVK::createTopLevelAccelerationStructure(
-	const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures)
+	const std::vector<AccelerationStructureInstance>& instances)
+{
+	return (TopLevelAccelerationStructureHandle*)gContext->top_level_acceleration_structure_pool.create(instances);
+}
+
+void BackendVK::updateTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle,
+	const std::vector<AccelerationStructureInstance>& instances)
 {
-	auto top_level_acceleration_structure = new TopLevelAccelerationStructureVK(bottom_level_acceleration_structures);
-	gContext->objects.insert(top_level_acceleration_structure);
-	return (TopLevelAccelerationStructureHandle*)top_level_acceleration_structure;
+	auto top_level_acceleration_structure = gContext->top_level_acceleration_structure_pool.get(handle);
+	top_level_acceleration_structure->update(instances);
 }
 
 void BackendVK::destroyTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle)
 {
-	auto top_level_acceleration_structure = (TopLevelAccelerationStructureVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyTopLevelAccelerationStructure(handle); }))
+		return;
+
+	auto top_level_acceleration_structure = gContext->top_level_acceleration_structure_pool.get(handle);
 
 	std::erase_if(gContext->top_level_acceleration_structures, [&](const auto& item) {
 		const auto& [binding, _acceleration_structure] = item;
 		return top_level_acceleration_structure == _acceleration_structure;
 	});
 
-	gContext->objects.erase(top_level_acceleration_structure);
-	delete top_level_acceleration_structure;
+	gContext->top_level_acceleration_structure_pool.destroy(handle);
 }
 
 StorageBufferHandle* BackendVK::createStorageBuffer(size_t size)
 {
-	auto buffer = new StorageBufferVK(size);
-	gContext->objects.insert(buffer);
-	return (StorageBufferHandle*)buffer;
+	return (StorageBufferHandle*)gContext->storage_buffer_pool.create(size);
 }
 
 void BackendVK::destroyStorageBuffer(StorageBufferHandle* handle)
 {
-	auto buffer = (StorageBufferVK*)handle;
+	if (DeferDestroyToRenderThread([this, handle] { destroyStorageBuffer(handle); }))
+		return;
+
+	auto buffer = gContext->storage_buffer_pool.get(handle);
 
 	std::erase_if(gContext->storage_buffers, [&](const auto& item) {
 		const auto& [binding, _buffer] = item;
 		return buffer == _buffer;
 	});
 
-	gContext->objects.erase(buffer);
-	delete buffer;
+	gContext->storage_buffer_pool.destroy(handle);
 }
 
 void BackendVK::writeStorageBufferMemory(StorageBufferHandle* handle, const void* memory, size_t size)
 {
-	auto buffer = (StorageBufferVK*)handle;
+	auto buffer = gContext->storage_buffer_pool.get(handle);
 	buffer->write(memory, size);
+
+	for (const auto& [binding, storage_buffer] : gContext->storage_buffers)
+	{
+		if (storage_buffer == buffer)
+			gContext->dirty_descriptor_bindings.insert(binding);
+	}
 }
 
 #endif
@@ -6,7 +6,7 @@
 
 namespace skygfx
 {
-	class BackendVK : public Backend, public RaytracingBackend
+	class BackendVK : public Backend, public RaytracingBackend, public BindlessBackend
 	{
 	public:
 		BackendVK(void* window, uint32_t width, uint32_t height, Adapter adapter, const std::unordered_set<Feature>& features);
@@ -14,6 +14,7 @@ namespace skygfx
 
 		void resize(uint32_t width, uint32_t height) override;
 		void setVsync(bool value) override;
+		void setFramesInFlight(uint32_t count) override;
 
 		void setTopology(Topology topology) override;
 		void setViewport(std::optional<Viewport> viewport) override;
@@ -26,6 +27,11 @@ namespace skygfx
 		void setVertexBuffer(const VertexBuffer** vertex_buffer, size_t count) override;
 		void setIndexBuffer(IndexBufferHandle* handle) override;
 		void setUniformBuffer(uint32_t binding, UniformBufferHandle* handle) override;
+		void setPushConstants(const void* memory, size_t size) override;
+		void setAsyncPipelineCompilation(bool value) override;
+		uint32_t getPendingPipelinesCount() override;
+		MemoryStats getMemoryStats() override;
+		void setShaderCacheDirectory(const std::string& path) override;
 		void setStorageBuffer(uint32_t binding, StorageBufferHandle* handle) override;
 		void setAccelerationStructure(uint32_t binding, TopLevelAccelerationStructureHandle* handle) override;
 		void setBlendMode(const std::optional<BlendMode>& value) override;
@@ -37,6 +43,7 @@ namespace skygfx
 		void setTextureAddress(TextureAddress value) override;
 		void setFrontFace(FrontFace value) override;
 		void setDepthBias(const std::optional<DepthBias> depth_bias) override;
+		void setStoreAction(StoreAction color, StoreAction depth_stencil) override;
 
 		void clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 			const std::optional<uint8_t>& stencil) override;
@@ -55,7 +62,7 @@ namespace skygfx
 		void writeTexturePixels(TextureHandle* handle, uint32_t width, uint32_t height, const void* memory,
 			uint32_t mip_level, uint32_t offset_x, uint32_t offset_y) override;
 		std::vector<uint8_t> readTexturePixels(TextureHandle* handle, uint32_t mip_level) override;
-		void generateMips(TextureHandle* handle) override;
+		void generateMips(TextureHandle* handle, MipmapFilter filter) override;
 		void destroyTexture(TextureHandle* handle) override;
 
 		RenderTargetHandle* createRenderTarget(uint32_t width, uint32_t height, TextureHandle* texture) override;
@@ -66,7 +73,7 @@ namespace skygfx
 		void destroyShader(ShaderHandle* handle) override;
 
 		RaytracingShaderHandle* createRaytracingShader(const std::string& raygen_code,
-			const std::vector<std::string>& miss_code, const std::string& closesthit_code,
+			const std::vector<std::string>& miss_code, const std::vector<std::string>& closesthit_code,
 			const std::vector<std::string>& defines) override;
 		void destroyRaytracingShader(RaytracingShaderHandle* handle) override;
 
@@ -82,18 +89,35 @@ namespace skygfx
 		void destroyUniformBuffer(UniformBufferHandle* handle) override;
 		void writeUniformBufferMemory(UniformBufferHandle* handle, const void* memory, size_t size) override;
 
+		UploadId writeTexturePixelsAsync(TextureHandle* handle, uint32_t width, uint32_t height,
+			const void* memory, uint32_t mip_level) override;
+		UploadId writeVertexBufferMemoryAsync(VertexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) override;
+		UploadId writeIndexBufferMemoryAsync(IndexBufferHandle* handle, const void* memory, size_t size,
+			size_t stride) override;
+		bool isUploadCompleted(UploadId id) override;
+		void waitUpload(UploadId id) override;
+
 		BottomLevelAccelerationStructureHandle* createBottomLevelAccelerationStructure(const void* vertex_memory,
 			uint32_t vertex_count, uint32_t vertex_stride, const void* index_memory, uint32_t index_count,
-			uint32_t index_stride, const glm::mat4& transform) override;
+			uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options) override;
+		BottomLevelAccelerationStructureHandle* createBottomLevelAccelerationStructure(VertexBufferHandle* vertex_buffer,
+			uint32_t vertex_count, uint32_t vertex_offset, uint32_t vertex_stride, VertexFormat vertex_format,
+			IndexBufferHandle* index_buffer, uint32_t index_count, uint32_t index_offset, uint32_t index_stride,
+			const glm::mat4& transform, const AccelerationStructureBuildOptions& options) override;
 		void destroyBottomLevelAccelerationStructure(BottomLevelAccelerationStructureHandle* handle) override;
 
 		TopLevelAccelerationStructureHandle* createTopLevelAccelerationStructure(
-			const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures) override;
+			const std::vector<AccelerationStructureInstance>& instances) override;
+		void updateTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle,
+			const std::vector<AccelerationStructureInstance>& instances) override;
 		void destroyTopLevelAccelerationStructure(TopLevelAccelerationStructureHandle* handle) override;
 
 		StorageBufferHandle* createStorageBuffer(size_t size) override;
 		void destroyStorageBuffer(StorageBufferHandle* handle) override;
 		void writeStorageBufferMemory(StorageBufferHandle* handle, const void* memory, size_t size) override;
+
+		uint32_t getBindlessTextureIndex(TextureHandle* handle) override;
 	};
 }
 
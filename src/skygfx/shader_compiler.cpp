@@ -15,7 +15,8 @@ std::vector<uint32_t> skygfx::CompileGlslToSpirv(ShaderStage stage, const std::s
 		{ ShaderStage::Fragment, EShLangFragment },
 		{ ShaderStage::Raygen, EShLangRayGen },
 		{ ShaderStage::Miss, EShLangMiss },
-		{ ShaderStage::ClosestHit, EShLangClosestHit }
+		{ ShaderStage::ClosestHit, EShLangClosestHit },
+		{ ShaderStage::Compute, EShLangCompute }
 	};
 
 	static bool inited = false;
@@ -66,6 +67,16 @@ std::vector<uint32_t> skygfx::CompileGlslToSpirv(ShaderStage stage, const std::s
 	return result;
 }
 
+static void SetPushConstantsBinding(spirv_cross::Compiler& compiler)
+{
+	auto resources = compiler.get_shader_resources();
+
+	for (const auto& push_constant_buffer : resources.push_constant_buffers)
+	{
+		compiler.set_decoration(push_constant_buffer.id, spv::DecorationBinding, PushConstantsBinding);
+	}
+}
+
 std::string skygfx::CompileSpirvToHlsl(const std::vector<uint32_t>& spirv, uint32_t version)
 {
 	auto compiler = spirv_cross::CompilerHLSL(spirv);
@@ -75,6 +86,8 @@ std::string skygfx::CompileSpirvToHlsl(const std::vector<uint32_t>& spirv, uint3
 	options.flatten_matrix_vertex_input_semantics = true;
 	compiler.set_hlsl_options(options);
 
+	SetPushConstantsBinding(compiler);
+
 	return compiler.compile();
 }
 
@@ -88,7 +101,10 @@ std::string skygfx::CompileSpirvToGlsl(const std::vector<uint32_t>& spirv, bool
 	options.version = version;
 	options.enable_420pack_extension = enable_420pack_extension;
 	options.force_flattened_io_blocks = force_flattened_io_blocks;
+	options.emit_push_constant_as_uniform_buffer = true;
 	compiler.set_common_options(options);
+
+	SetPushConstantsBinding(compiler);
 	
 	bool fix_varyings = (es && version <= 300) || force_flattened_io_blocks;
 
@@ -140,6 +156,13 @@ std::string skygfx::CompileSpirvToMsl(const std::vector<uint32_t>& spirv)
 	options.set_msl_version(2, 3);
 	compiler.set_msl_options(options);
 
+	auto push_constants_binding = spirv_cross::MSLResourceBinding();
+	push_constants_binding.stage = compiler.get_execution_model();
+	push_constants_binding.desc_set = spirv_cross::kPushConstDescSet;
+	push_constants_binding.binding = spirv_cross::kPushConstBinding;
+	push_constants_binding.msl_buffer = PushConstantsBinding;
+	compiler.add_msl_resource_binding(push_constants_binding);
+
 	return compiler.compile();
 }
 
@@ -158,7 +181,8 @@ ShaderReflection skygfx::MakeSpirvReflection(const std::vector<uint32_t>& spirv)
 		{ SPV_REFLECT_SHADER_STAGE_FRAGMENT_BIT, ShaderStage::Fragment },
 		{ SPV_REFLECT_SHADER_STAGE_RAYGEN_BIT_KHR, ShaderStage::Raygen },
 		{ SPV_REFLECT_SHADER_STAGE_MISS_BIT_KHR, ShaderStage::Miss },
-		{ SPV_REFLECT_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, ShaderStage::ClosestHit }
+		{ SPV_REFLECT_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, ShaderStage::ClosestHit },
+		{ SPV_REFLECT_SHADER_STAGE_COMPUTE_BIT, ShaderStage::Compute }
 	};
 
 	auto refl = spv_reflect::ShaderModule(spirv);
@@ -181,6 +205,14 @@ ShaderReflection skygfx::MakeSpirvReflection(const std::vector<uint32_t>& spirv)
 	r = refl.EnumerateDescriptorSets(&descriptor_sets_count, descriptor_sets.data());
 	assert(r == SPV_REFLECT_RESULT_SUCCESS);
 
+	uint32_t push_constant_blocks_count = 0;
+	r = refl.EnumeratePushConstantBlocks(&push_constant_blocks_count, nullptr);
+	assert(r == SPV_REFLECT_RESULT_SUCCESS);
+
+	std::vector<SpvReflectBlockVariable*> push_constant_blocks(push_constant_blocks_count);
+	r = refl.EnumeratePushConstantBlocks(&push_constant_blocks_count, push_constant_blocks.data());
+	assert(r == SPV_REFLECT_RESULT_SUCCESS);
+
 	ShaderReflection result;
 
 	auto stage = refl.GetShaderStage();
@@ -188,9 +220,18 @@ ShaderReflection skygfx::MakeSpirvReflection(const std::vector<uint32_t>& spirv)
 
 	for (const auto& descriptor_binding : descriptor_bindings)
 	{
+		if (descriptor_binding->set == BindlessTexturesSet)
+		{
+			result.bindless_textures = true;
+			continue;
+		}
+
 		auto binding = descriptor_binding->binding;
 		auto type = DescriptorTypeMap.at(descriptor_binding->descriptor_type);
 
+		if (type == ShaderReflection::DescriptorType::UniformBuffer && binding == PushConstantsBinding)
+			throw std::runtime_error("uniform buffer binding " + std::to_string(binding) + " is reserved for push constants");
+
 		auto& typed_bindings = result.typed_descriptor_bindings[type];
 		assert(!typed_bindings.contains(binding));
 
@@ -214,5 +255,16 @@ ShaderReflection skygfx::MakeSpirvReflection(const std::vector<uint32_t>& spirv)
 		}
 	}
 
+	// glsl allows only one push constant block per stage
+	assert(push_constant_blocks.size() <= 1);
+
+	for (const auto& push_constant_block : push_constant_blocks)
+	{
+		result.push_constants = ShaderReflection::PushConstants{
+			.type_name = push_constant_block->type_description->type_name,
+			.size = push_constant_block->size
+		};
+	}
+
 	return result;
 }
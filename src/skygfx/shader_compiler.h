@@ -8,6 +8,12 @@
 
 namespace skygfx
 {
+	// backends without native push constants receive them through a uniform buffer at this binding
+	constexpr uint32_t PushConstantsBinding = 13;
+
+	// bindless textures are declared as an unsized sampler array at binding 0 of this set
+	constexpr uint32_t BindlessTexturesSet = 1;
+
 	std::vector<uint32_t> CompileGlslToSpirv(ShaderStage stage, const std::string& code,
 		const std::vector<std::string>& defines = {});
 	std::string CompileSpirvToHlsl(const std::vector<uint32_t>& spirv, uint32_t version);
@@ -33,7 +39,15 @@ namespace skygfx
 			std::string type_name;
 		};
 
+		struct PushConstants
+		{
+			std::string type_name;
+			uint32_t size;
+		};
+
 		std::unordered_map<DescriptorType, std::unordered_map<uint32_t, Descriptor>> typed_descriptor_bindings;
+		std::optional<PushConstants> push_constants;
+		bool bindless_textures = false;
 		std::unordered_map<uint32_t/*set*/, std::unordered_set<uint32_t>/*bindings*/> descriptor_sets;
 		ShaderStage stage;
 	};
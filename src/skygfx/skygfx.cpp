@@ -10,6 +10,7 @@ using namespace skygfx;
 
 static Backend* gBackend = nullptr;
 static RaytracingBackend* gRaytracingBackend = nullptr;
+static BindlessBackend* gBindlessBackend = nullptr;
 static glm::u32vec2 gSize = { 0, 0 };
 static bool gVsync = false;
 static uint32_t gDrawcalls = 0;
@@ -71,15 +72,29 @@ void Texture::write(uint32_t width, uint32_t height, const void* memory, uint32_
 	gBackend->writeTexturePixels(mTextureHandle, width, height, memory, mip_level, offset_x, offset_y);
 }
 
+UploadId Texture::writeAsync(const void* memory, uint32_t mip_level)
+{
+	assert(mip_level < mMipCount);
+	assert(memory != nullptr);
+	return gBackend->writeTexturePixelsAsync(mTextureHandle, GetMipWidth(mWidth, mip_level),
+		GetMipHeight(mHeight, mip_level), memory, mip_level);
+}
+
 std::vector<uint8_t> Texture::read(uint32_t mip_level)
 {
 	assert(mip_level < mMipCount);
 	return gBackend->readTexturePixels(mTextureHandle, mip_level);
 }
 
-void Texture::generateMips()
+uint32_t Texture::getBindlessIndex() const
 {
-	gBackend->generateMips(mTextureHandle);
+	assert(gBindlessBackend != nullptr);
+	return gBindlessBackend->getBindlessTextureIndex(mTextureHandle);
+}
+
+void Texture::generateMips(MipmapFilter filter)
+{
+	gBackend->generateMips(mTextureHandle, filter);
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept
@@ -166,11 +181,17 @@ Shader& Shader::operator=(Shader&& other) noexcept
 // raytracing shader
 
 RaytracingShader::RaytracingShader(const std::string& raygen_code, const std::vector<std::string>& miss_code,
-	const std::string& closesthit_code, const std::vector<std::string>& defines)
+	const std::vector<std::string>& closesthit_code, const std::vector<std::string>& defines)
 {
 	mRaytracingShaderHandle = gRaytracingBackend->createRaytracingShader(raygen_code, miss_code, closesthit_code, defines);
 }
 
+RaytracingShader::RaytracingShader(const std::string& raygen_code, const std::vector<std::string>& miss_code,
+	const std::string& closesthit_code, const std::vector<std::string>& defines) :
+	RaytracingShader(raygen_code, miss_code, std::vector<std::string>{ closesthit_code }, defines)
+{
+}
+
 RaytracingShader::~RaytracingShader()
 {
 	if (gRaytracingBackend)
@@ -243,6 +264,11 @@ void VertexBuffer::write(const void* memory, size_t size, size_t stride)
 	gBackend->writeVertexBufferMemory(mVertexBufferHandle, memory, size, stride);
 }
 
+UploadId VertexBuffer::writeAsync(const void* memory, size_t size, size_t stride)
+{
+	return gBackend->writeVertexBufferMemoryAsync(mVertexBufferHandle, memory, size, stride);
+}
+
 // index buffer
 
 IndexBuffer::IndexBuffer(size_t size, size_t stride) : Buffer(size)
@@ -285,6 +311,11 @@ void IndexBuffer::write(const void* memory, size_t size, size_t stride)
 	gBackend->writeIndexBufferMemory(mIndexBufferHandle, memory, size, stride);
 }
 
+UploadId IndexBuffer::writeAsync(const void* memory, size_t size, size_t stride)
+{
+	return gBackend->writeIndexBufferMemoryAsync(mIndexBufferHandle, memory, size, stride);
+}
+
 // uniform buffer
 
 UniformBuffer::UniformBuffer(size_t size) : Buffer(size)
@@ -373,13 +404,26 @@ void StorageBuffer::write(const void* memory, size_t size)
 
 BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(const void* vertex_memory, uint32_t vertex_count,
 	uint32_t vertex_offset, uint32_t vertex_stride, const void* index_memory, uint32_t index_count,
-	uint32_t index_offset, uint32_t index_stride, const glm::mat4& transform)
+	uint32_t index_offset, uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options)
 {
 	auto vertex_memory_with_offset = (void*)((size_t)vertex_memory + vertex_offset);
 	auto index_memory_with_offset = (void*)((size_t)index_memory + index_offset);
 
 	mBottomLevelAccelerationStructureHandle = gRaytracingBackend->createBottomLevelAccelerationStructure(vertex_memory_with_offset,
-		vertex_count, vertex_stride, index_memory_with_offset, index_count, index_stride, transform);
+		vertex_count, vertex_stride, index_memory_with_offset, index_count, index_stride, transform, options);
+}
+
+BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(const VertexBuffer& vertex_buffer, uint32_t vertex_count,
+	uint32_t vertex_offset, uint32_t vertex_stride, VertexFormat vertex_format, const IndexBuffer& index_buffer,
+	uint32_t index_count, uint32_t index_offset, uint32_t index_stride, const glm::mat4& transform,
+	const AccelerationStructureBuildOptions& options)
+{
+	VertexBufferHandle* vertex_buffer_handle = vertex_buffer;
+	IndexBufferHandle* index_buffer_handle = index_buffer;
+
+	mBottomLevelAccelerationStructureHandle = gRaytracingBackend->createBottomLevelAccelerationStructure(
+		vertex_buffer_handle, vertex_count, vertex_offset, vertex_stride, vertex_format,
+		index_buffer_handle, index_count, index_offset, index_stride, transform, options);
 }
 
 BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
@@ -390,10 +434,15 @@ BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
 
 // top level acceleration structure
 
+TopLevelAccelerationStructure::TopLevelAccelerationStructure(const std::vector<AccelerationStructureInstance>& instances)
+{
+	mTopLevelAccelerationStructureHandle = gRaytracingBackend->createTopLevelAccelerationStructure(instances);
+}
+
 TopLevelAccelerationStructure::TopLevelAccelerationStructure(
-	const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures)
+	const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures) :
+	TopLevelAccelerationStructure(CreateInstances(bottom_level_acceleration_structures))
 {
-	mTopLevelAccelerationStructureHandle = gRaytracingBackend->createTopLevelAccelerationStructure(bottom_level_acceleration_structures);
 }
 
 TopLevelAccelerationStructure::TopLevelAccelerationStructure(
@@ -408,6 +457,11 @@ TopLevelAccelerationStructure::~TopLevelAccelerationStructure()
 		gRaytracingBackend->destroyTopLevelAccelerationStructure(mTopLevelAccelerationStructureHandle);
 }
 
+void TopLevelAccelerationStructure::update(const std::vector<AccelerationStructureInstance>& instances)
+{
+	gRaytracingBackend->updateTopLevelAccelerationStructure(mTopLevelAccelerationStructureHandle, instances);
+}
+
 std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>
 	TopLevelAccelerationStructure::CreateIndexedBlases(const std::vector<BottomLevelAccelerationStructureHandle*>& blases)
 {
@@ -419,6 +473,21 @@ std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>
 	return result;
 }
 
+std::vector<AccelerationStructureInstance> TopLevelAccelerationStructure::CreateInstances(
+	const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& blases)
+{
+	std::vector<AccelerationStructureInstance> result;
+	for (auto [instance_id, blas] : blases)
+	{
+		auto instance = AccelerationStructureInstance{
+			.blas = blas,
+			.instance_id = instance_id
+		};
+		result.push_back(instance);
+	}
+	return result;
+}
+
 // helper functions
 
 TopologyKind skygfx::GetTopologyKind(Topology topology)
@@ -669,6 +738,14 @@ void skygfx::Initialize(void* window, uint32_t width, uint32_t height, std::opti
 		if (gRaytracingBackend == nullptr)
 			throw std::runtime_error("this backend does not support raytracing");
 	}
+
+	if (features.contains(Feature::BindlessTextures))
+	{
+		gBindlessBackend = dynamic_cast<BindlessBackend*>(gBackend);
+
+		if (gBindlessBackend == nullptr)
+			throw std::runtime_error("this backend does not support bindless textures");
+	}
 }
 
 void skygfx::Finalize()
@@ -687,6 +764,8 @@ void skygfx::Finalize()
 	{
 		gRaytracingBackend = nullptr;
 	}
+
+	gBindlessBackend = nullptr;
 }
 
 void skygfx::Resize(uint32_t width, uint32_t height)
@@ -706,6 +785,11 @@ bool skygfx::IsVsyncEnabled()
 	return gVsync;
 }
 
+void skygfx::SetFramesInFlight(uint32_t count)
+{
+	gBackend->setFramesInFlight(count);
+}
+
 void skygfx::SetTopology(Topology topology)
 {
 	gBackend->setTopology(topology);
@@ -846,6 +930,26 @@ void skygfx::SetDepthBias(const std::optional<DepthBias> depth_bias)
 	gBackend->setDepthBias(depth_bias);
 }
 
+void skygfx::SetStoreAction(StoreAction color, StoreAction depth_stencil)
+{
+	gBackend->setStoreAction(color, depth_stencil);
+}
+
+void skygfx::SetAsyncPipelineCompilation(bool value)
+{
+	gBackend->setAsyncPipelineCompilation(value);
+}
+
+uint32_t skygfx::GetPendingPipelinesCount()
+{
+	return gBackend->getPendingPipelinesCount();
+}
+
+void skygfx::SetShaderCacheDirectory(const std::string& path)
+{
+	gBackend->setShaderCacheDirectory(path);
+}
+
 void skygfx::Clear(const std::optional<glm::vec4>& color, const std::optional<float>& depth,
 	const std::optional<uint8_t>& stencil)
 {
@@ -888,6 +992,19 @@ PresentResult skygfx::Present()
 	return result;
 }
 
+bool skygfx::IsUploadCompleted(UploadId id)
+{
+	return id == 0 || gBackend->isUploadCompleted(id);
+}
+
+void skygfx::WaitUpload(UploadId id)
+{
+	if (id == 0)
+		return;
+
+	gBackend->waitUpload(id);
+}
+
 void skygfx::SetVertexBuffer(const void* memory, size_t size, size_t stride)
 {
 	assert(size > 0);
@@ -939,6 +1056,12 @@ void skygfx::SetUniformBuffer(uint32_t binding, const void* memory, size_t size)
 	SetUniformBuffer(binding, buffer);
 }
 
+void skygfx::SetPushConstants(const void* memory, size_t size)
+{
+	assert(size > 0);
+	gBackend->setPushConstants(memory, size);
+}
+
 void skygfx::SetStorageBuffer(uint32_t binding, const void* memory, size_t size)
 {
 	assert(size > 0);
@@ -986,10 +1109,16 @@ BackendType skygfx::GetBackendType()
 	return gBackendType;
 }
 
+MemoryStats skygfx::GetMemoryStats()
+{
+	return gBackend->getMemoryStats();
+}
+
 std::unordered_set<BackendType> skygfx::GetAvailableBackends(const std::unordered_set<Feature>& features)
 {
 	static const std::unordered_map<Feature, std::unordered_set<BackendType>> FeatureCoverageMap = {
-		{ Feature::Raytracing, { BackendType::Vulkan } }
+		{ Feature::Raytracing, { BackendType::Vulkan } },
+		{ Feature::BindlessTextures, { BackendType::Vulkan } }
 	};
 
 	static const std::unordered_set<BackendType> AvailableBackendsForPlatform = {
@@ -35,9 +35,13 @@ namespace skygfx
 
 	enum class Feature
 	{
-		Raytracing
+		Raytracing,
+		BindlessTextures
 	};
 
+	// returned by async writes, 0 means the upload was completed immediately
+	using UploadId = uint64_t;
+
 	enum class VertexFormat
 	{
 		Float1,
@@ -63,13 +67,20 @@ namespace skygfx
 		RGBA8UNorm
 	};
 
+	enum class MipmapFilter
+	{
+		Box,
+		Kaiser
+	};
+
 	enum class ShaderStage
 	{
 		Vertex,
 		Fragment,
 		Raygen,
 		Miss,
-		ClosestHit
+		ClosestHit,
+		Compute
 	};
 
 	using TextureHandle = struct TextureHandle;
@@ -93,6 +104,10 @@ namespace skygfx
 		noncopyable& operator=(const noncopyable&) = delete;
 	};
 
+	// with the vulkan backend resources may be destroyed on any thread, destroys from other
+	// threads than the one that initialized skygfx take effect at the start of the next frame,
+	// everything else including creation stays on that thread
+
 	class Texture : private noncopyable
 	{
 	public:
@@ -103,8 +118,13 @@ namespace skygfx
 
 		void write(uint32_t width, uint32_t height, const void* memory, uint32_t mip_level = 0,
 			uint32_t offset_x = 0, uint32_t offset_y = 0);
+		// writes a whole mip, the texture must not be in use by rendering until the upload is completed
+		UploadId writeAsync(const void* memory, uint32_t mip_level = 0);
 		std::vector<uint8_t> read(uint32_t mip_level = 0);
-		void generateMips();
+		void generateMips(MipmapFilter filter = MipmapFilter::Box);
+		// index into the bindless texture array, textures are registered in it on creation
+		// when Feature::BindlessTextures is enabled
+		uint32_t getBindlessIndex() const;
 
 		Texture& operator=(Texture&& other) noexcept;
 
@@ -157,6 +177,9 @@ namespace skygfx
 	class RaytracingShader : private noncopyable
 	{
 	public:
+		// hit group is selected by instance sbt_offset + traceRayEXT sbtRecordOffset + geometry index * sbtRecordStride
+		RaytracingShader(const std::string& raygen_code, const std::vector<std::string>& miss_code,
+			const std::vector<std::string>& closesthit_code, const std::vector<std::string>& defines = {});
 		RaytracingShader(const std::string& raygen_code, const std::vector<std::string>& miss_code,
 			const std::string& closesthit_code, const std::vector<std::string>& defines = {});
 		virtual ~RaytracingShader();
@@ -211,7 +234,10 @@ namespace skygfx
 			write(values.data(), values.size());
 		}
 
-		operator VertexBufferHandle* () { return mVertexBufferHandle; }
+		// the buffer must not be in use by rendering until the upload is completed
+		UploadId writeAsync(const void* memory, size_t size, size_t stride);
+
+		operator VertexBufferHandle* () const { return mVertexBufferHandle; }
 
 	private:
 		VertexBufferHandle* mVertexBufferHandle = nullptr;
@@ -247,7 +273,10 @@ namespace skygfx
 			write(values.data(), values.size());
 		}
 
-		operator IndexBufferHandle* () { return mIndexBufferHandle; }
+		// the buffer must not be in use by rendering until the upload is completed
+		UploadId writeAsync(const void* memory, size_t size, size_t stride);
+
+		operator IndexBufferHandle* () const { return mIndexBufferHandle; }
 
 	private:
 		IndexBufferHandle* mIndexBufferHandle = nullptr;
@@ -301,26 +330,48 @@ namespace skygfx
 		StorageBufferHandle* mStorageBufferHandle = nullptr;
 	};
 
+	enum class AccelerationStructureBuildPreference
+	{
+		FastTrace,
+		FastBuild
+	};
+
+	struct AccelerationStructureBuildOptions
+	{
+		AccelerationStructureBuildPreference preference = AccelerationStructureBuildPreference::FastTrace;
+		bool allow_update = false;
+		bool allow_compaction = false;
+	};
+
+	// builds are deferred and batched, all structures created before the next
+	// top level acceleration structure build are built together
 	class BottomLevelAccelerationStructure : public noncopyable
 	{
 	public:
 		BottomLevelAccelerationStructure(const void* vertex_memory, uint32_t vertex_count, uint32_t vertex_offset,
 			uint32_t vertex_stride, const void* index_memory, uint32_t index_count, uint32_t index_offset,
-			uint32_t index_stride, const glm::mat4& transform);
+			uint32_t index_stride, const glm::mat4& transform, const AccelerationStructureBuildOptions& options = {});
+		// offsets are in bytes, buffers are used in place and must stay alive until the structure is built
+		BottomLevelAccelerationStructure(const VertexBuffer& vertex_buffer, uint32_t vertex_count, uint32_t vertex_offset,
+			uint32_t vertex_stride, VertexFormat vertex_format, const IndexBuffer& index_buffer, uint32_t index_count,
+			uint32_t index_offset, uint32_t index_stride, const glm::mat4& transform,
+			const AccelerationStructureBuildOptions& options = {});
 		~BottomLevelAccelerationStructure();
 
 		template<class Vertex, class Index>
 		explicit BottomLevelAccelerationStructure(const Vertex* vertex_memory, uint32_t vertex_count,
 			uint32_t vertex_offset, const Index* index_memory, uint32_t index_count, uint32_t index_offset,
-			const glm::mat4& transform) : BottomLevelAccelerationStructure(vertex_memory, vertex_count,
-				vertex_offset, sizeof(Vertex), index_memory, index_count, index_offset, sizeof(Index), transform)
+			const glm::mat4& transform, const AccelerationStructureBuildOptions& options = {}) :
+			BottomLevelAccelerationStructure(vertex_memory, vertex_count, vertex_offset, sizeof(Vertex),
+				index_memory, index_count, index_offset, sizeof(Index), transform, options)
 		{}
 
 		template<class Vertex, class Index>
 		explicit BottomLevelAccelerationStructure(const std::vector<Vertex>& vertices, uint32_t vertex_offset,
-			const std::vector<Index>& indices, uint32_t index_offset, const glm::mat4& transform)
+			const std::vector<Index>& indices, uint32_t index_offset, const glm::mat4& transform,
+			const AccelerationStructureBuildOptions& options = {})
 			: BottomLevelAccelerationStructure(vertices.data(), (uint32_t)vertices.size(), vertex_offset,
-				indices.data(), (uint32_t)indices.size(), index_offset, transform)
+				indices.data(), (uint32_t)indices.size(), index_offset, transform, options)
 		{}
 
 		operator BottomLevelAccelerationStructureHandle* () { return mBottomLevelAccelerationStructureHandle; }
@@ -329,20 +380,35 @@ namespace skygfx
 		BottomLevelAccelerationStructureHandle* mBottomLevelAccelerationStructureHandle = nullptr;
 	};
 
+	struct AccelerationStructureInstance
+	{
+		BottomLevelAccelerationStructureHandle* blas = nullptr;
+		glm::mat4 transform = glm::mat4(1.0f);
+		uint32_t instance_id = 0; // gl_InstanceCustomIndexEXT, 24 bits
+		uint8_t mask = 0xFF;
+		uint32_t sbt_offset = 0; // hit group offset in shader binding table, 24 bits
+	};
+
 	class TopLevelAccelerationStructure : public noncopyable
 	{
 	public:
+		TopLevelAccelerationStructure(const std::vector<AccelerationStructureInstance>& instances);
 		TopLevelAccelerationStructure(
 			const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& bottom_level_acceleration_structures);
 		TopLevelAccelerationStructure(
 			const std::vector<BottomLevelAccelerationStructureHandle*>& bottom_level_acceleration_structures);
 		~TopLevelAccelerationStructure();
 
+		// refits in place, instance count must stay the same
+		void update(const std::vector<AccelerationStructureInstance>& instances);
+
 		operator TopLevelAccelerationStructureHandle* () { return mTopLevelAccelerationStructureHandle; }
 
 	private:
 		std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>
 			CreateIndexedBlases(const std::vector<BottomLevelAccelerationStructureHandle*>& blases);
+		std::vector<AccelerationStructureInstance> CreateInstances(
+			const std::vector<std::tuple<uint32_t, BottomLevelAccelerationStructureHandle*>>& blases);
 
 	private:
 		TopLevelAccelerationStructureHandle* mTopLevelAccelerationStructureHandle = nullptr;
@@ -576,11 +642,41 @@ namespace skygfx
 		bool operator==(const DepthBias& other) const = default;
 	};
 
+	enum class StoreAction
+	{
+		Store,
+		DontCare // contents are not needed once the render targets are switched or presented
+	};
+
 	struct PresentResult
 	{
 		uint32_t drawcalls = 0;
 	};
 
+	struct MemoryStats
+	{
+		// budget is what the process can use before the driver starts to evict or fail,
+		// it falls back to the heap size when the driver does not report it
+		struct Heap
+		{
+			uint64_t budget = 0;
+			uint64_t usage = 0;
+			bool device_local = false;
+		};
+
+		struct Category
+		{
+			uint64_t size = 0;
+			uint64_t peak_size = 0;
+		};
+
+		std::vector<Heap> heaps;
+		Category textures;
+		Category buffers;
+		Category render_targets; // depth stencil attachments, color attachments are counted as textures
+		Category acceleration_structures;
+	};
+
 	void Initialize(void* window, uint32_t width, uint32_t height, std::optional<BackendType> type = std::nullopt,
 		Adapter adapter = Adapter::HighPerformance, const std::unordered_set<Feature>& features = {});
 	void Finalize();
@@ -590,6 +686,8 @@ namespace skygfx
 	void SetVsync(bool value);
 	bool IsVsyncEnabled();
 
+	void SetFramesInFlight(uint32_t count);
+
 	void SetTopology(Topology topology);
 	void SetViewport(const std::optional<Viewport>& viewport);
 	void SetScissor(const std::optional<Scissor>& scissor);
@@ -617,6 +715,16 @@ namespace skygfx
 	void SetFrontFace(FrontFace value);
 	void SetDepthBias(const std::optional<DepthBias> depth_bias);
 
+	// applies once, to the render targets that are bound when it is called
+	void SetStoreAction(StoreAction color, StoreAction depth_stencil);
+
+	// pipelines are compiled on worker threads, draws are skipped until their pipeline is ready
+	void SetAsyncPipelineCompilation(bool value);
+	uint32_t GetPendingPipelinesCount();
+
+	// linked programs are stored in this directory and reused on later runs, only the OpenGL backend uses it
+	void SetShaderCacheDirectory(const std::string& path);
+
 	void Clear(const std::optional<glm::vec4>& color = glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f },
 		const std::optional<float>& depth = 1.0f, const std::optional<uint8_t>& stencil = 0);
 	void Draw(uint32_t vertex_count, uint32_t vertex_offset = 0, uint32_t instance_count = 1);
@@ -628,6 +736,9 @@ namespace skygfx
 
 	PresentResult Present();
 
+	bool IsUploadCompleted(UploadId id);
+	void WaitUpload(UploadId id);
+
 	void SetVertexBuffer(const void* memory, size_t size, size_t stride);
 
 	template<class T>
@@ -664,6 +775,16 @@ namespace skygfx
 		SetUniformBuffer(binding, &const_cast<T&>(value), sizeof(T));
 	}
 
+	// small per-draw data for the push_constant block of the current shader,
+	// backends without push constants bind it as a uniform buffer at binding 13
+	void SetPushConstants(const void* memory, size_t size);
+
+	template <class T>
+	void SetPushConstants(const T& value)
+	{
+		SetPushConstants(&value, sizeof(T));
+	}
+
 	void SetStorageBuffer(uint32_t binding, const void* memory, size_t size);
 
 	uint32_t GetWidth();
@@ -675,6 +796,9 @@ namespace skygfx
 
 	BackendType GetBackendType();
 
+	// only the Vulkan and OpenGL backends report memory, heaps are empty when the driver cannot be queried
+	MemoryStats GetMemoryStats();
+
 	std::unordered_set<BackendType> GetAvailableBackends(const std::unordered_set<Feature>& features = {});
 	std::optional<BackendType> GetDefaultBackend(const std::unordered_set<Feature>& features = {});
 